@@ -1,34 +1,86 @@
 #include <iostream>
 #include <vector>
-#include <queue>
 #include <random>
 #include <map>
 #include <ctime>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <queue>
+#include <functional>
+#include <cmath>
 #include <boost/thread.hpp>
-#include <boost/interprocess/sync/interprocess_semaphore.hpp>
 #include <boost/chrono.hpp>
+#include <chrono>
 #include <atomic>
+#include "dispatcher.hpp"
+#include "dary_heap.hpp"
+#include "trace.hpp"
+#include "tsc_clock.hpp"
+#include "epoch_reclamation.hpp"
+#include "autotuner.hpp"
+#include "wait_estimator.hpp"
+#include "circuit.hpp"
+#include "pauli.hpp"
+#include "mps.hpp"
 
+/*
+Представление состояния для задачи со схемой
+Auto - вектор состояния двойной точности, пока хватает памяти, иначе MPS
+StateVectorFloat - вектор одинарной точности: вдвое меньше памяти
+для задач, которым достаточно ~1e-6
+ */
+enum class SimulationBackend { Auto, StateVector, StateVectorFloat, Mps };
+
+/*
+Планирование, пока задача на нескольких процессорах ждет свободных
+- Greedy - любая задача начинается, как только есть процессор;
+  большая задача может ждать бесконечно
+- Strict - пока ждет старшая задача на нескольких процессорах, младшие
+  не начинаются (порядок Task::operator<), процессоры простаивают
+- Backfill - EASY: для старшей ожидающей задачи по оценкам длительности
+  вычисляется момент, когда освободятся нужные процессоры (shadow);
+  младшие начинаются на этих процессорах, только если успеют до него,
+  на остальных - свободно
+ */
+enum class SchedulingMode { Greedy, Strict, Backfill };
 
 class QuantumSimulator {
 public:
     /*
     в классе
     - 4 квантовых процессора
-    - Семафор на 4 одновременных задачи
+    - Диспетчер задач с семафором на 4 одновременных задачи
     - Счетчики задач для каждого процессора
     - Генератор уникальных ID задач
+    - Снимок исправных процессоров для чтения без блокировок
      */
     QuantumSimulator() : 
+        healthy_processors(nullptr),
         available_processors(4),
-        task_semaphore(4),
-        next_task_id(1)  // Начинаем нумерацию задач с 1
+        next_task_id(1),  // Начинаем нумерацию задач с 1
+        wait_estimator(1000.0)  // Пока нет замеров - середина 500-1500 мс
     {
         // Инициализация статусов процессоров и счетчиков задач
         for (int i = 0; i < 4; ++i) {
             processor_status[i] = true;  // Все процессоры исправны
             processor_task_count[i] = 0; // Начальное количество задач - 0
+            processor_units[i] = 0;
+            processor_maintenance[i] = 0;
+            drain_deadline[i] = 0;
+            maintenance_epoch[i] = 0;
+            processor_circuit_count[i] = 0;
+            processor_generation[i] = 0;
+            processor_reserved[i] = false;
+            busy_until[i] = 0;
         }
+        for (int k = 0; k <= 4; ++k) learned_runtime_ms[k] = 1000.0;  // Пока нет замеров - середина 500-1500 мс
+        healthy_processors.store(make_snapshot());
+    }
+
+    ~QuantumSimulator() {
+        delete healthy_processors.load();
     }
 
     /*
@@ -36,24 +88,177 @@ public:
     Приоритет задачи (1 - высший)
     is_critical флаг критической задачи
     task_id номер задачи 
+
+    runtime_ms - объявленная длительность (имитация работы длится столько же),
+    0 - неизвестна, планировщик использует изученную
      */
-    void add_task(int priority, bool is_critical, int task_id = -1) {
-        boost::unique_lock<boost::mutex> lock(task_mutex);
-        
-        // Генерируем новый ID, если не указан
-        int actual_id = (task_id == -1) ? next_task_id++ : task_id;
-        
-        // Добавляем задачу в приоритетную очередь
-        tasks.push(Task{priority, is_critical, actual_id});
-        
-        lock.unlock();
-        task_condition.notify_one();  // Уведомляем один ожидающий поток
+    void add_task(int priority, bool is_critical, int task_id = -1, double runtime_ms = 0.0) {
+        submit(priority, is_critical, task_id, -1, 1, runtime_ms);
+    }
+
+    /*
+    Малая задача: занимает units единиц емкости процессора и выполняется
+    на нем вместе с другими (см. set_processor_capacity)
+     */
+    void add_small_task(int priority, bool is_critical, int units, int task_id = -1, double runtime_ms = 0.0) {
+        submit(priority, is_critical, task_id, -1, 1, runtime_ms, units);
+    }
+
+    /*
+    Емкость процессора в единицах (до start())
+    - 0 (по умолчанию) - емкость не учитывается: число одновременных задач
+      ограничивает только семафор, задачи предпочитают свободные процессоры
+    - 1 - процессор занят одной задачей целиком
+    - больше - обычные задачи и задачи на нескольких процессорах занимают
+      всю емкость, малые задачи и схемы до small_circuit_qubits кубитов -
+      свои единицы, поэтому на процессоре выполняются несколько малых задач
+      сразу; слотов семафора становится по числу единиц (не больше рабочих
+      потоков)
+     */
+    void set_processor_capacity(int units) {
+        processor_capacity = std::max(0, std::min(units, max_processor_capacity));
+        set_slots(slot_limit());
+    }
+
+    // Одновременных задач не больше, чем помещается на процессоры
+    int slot_limit() const {
+        return processor_capacity > 0 ? std::min(worker_count, 4 * processor_capacity) : 4;
+    }
+
+    /*
+    Задача, которой нужны processors процессоров одновременно
+    (например, распределенный вектор состояния); processors
+    ограничивается 1-4 и текущим числом слотов семафора (см. gang_size)
+     */
+    void add_gang_task(int priority, bool is_critical, int processors, int task_id = -1, double runtime_ms = 0.0) {
+        int count = gang_size(processors);
+        if (count != processors) {
+            std::cout << "Задаче нужно " << processors << " процессоров, выполнится на " << count << "\n";
+        }
+        submit(priority, is_critical, task_id, -1, count, runtime_ms);
+    }
+
+    /*
+    Режим планирования при ожидании задач на нескольких процессорах (до start())
+     */
+    void set_scheduling(SchedulingMode mode) {
+        scheduling = mode;
+    }
+
+    /*
+    Регистрация параметризованной схемы: компилируется один раз
+    observable - строки Паули, среднее которых (энергию) задача вычисляет
+    по конечному состоянию вместо выборки; пусто - только <Z0>
+    Возвращает номер схемы для add_circuit_task
+     */
+    int register_circuit(const ParameterizedCircuit& circuit,
+                         const std::vector<PauliString>& observable = std::vector<PauliString>()) {
+        std::shared_ptr<const CompiledCircuit> compiled(new CompiledCircuit(circuit.compile()));
+        boost::lock_guard<boost::mutex> lock(circuits_mutex);
+        circuits.push_back(compiled);
+        observables.push_back(std::make_shared<const std::vector<PauliString>>(observable));
+        circuit_home.push_back(-1);
+        return static_cast<int>(circuits.size()) - 1;
+    }
+
+    /*
+    Задача - запуск схемы circuit_id с параметрами params
+    Задачи одной схемы направляются на один процессор, пока он исправен
+    backend - представление состояния; Auto выбирает MPS для схем больше
+    state_vector_qubits кубитов
+     */
+    int add_circuit_task(int priority, bool is_critical, int circuit_id, const std::vector<double>& params,
+                         SimulationBackend backend = SimulationBackend::Auto) {
+        int task_id = next_task_id++;
+        int units = 0;
+        {
+            boost::lock_guard<boost::mutex> lock(circuits_mutex);
+            if (backend == SimulationBackend::Auto) {
+                backend = circuits[circuit_id]->qubits() > state_vector_qubits ? SimulationBackend::Mps
+                                                                               : SimulationBackend::StateVector;
+            }
+            circuit_jobs[task_id] = CircuitJob{params, backend, nullptr};
+            // Малая схема на векторе состояния занимает одну единицу емкости
+            if (backend != SimulationBackend::Mps && circuits[circuit_id]->qubits() <= small_circuit_qubits) units = 1;
+        }
+        submit(priority, is_critical, task_id, circuit_id, 1, 0.0, units);
+        return task_id;
+    }
+
+    /*
+    Наибольшая связь MPS для задач, выполняемых после вызова
+    Больше - точнее и медленнее (SVD вентиля ~ bond^3)
+     */
+    void set_mps_bond(int bond) {
+        mps_bond.store(bond);
+    }
+
+    /*
+    Контрольные точки задач со схемами: снимок состояния и номер ядра
+    каждые kernels ядер; 0 - без точек (после сбоя схема начинается заново)
+     */
+    void set_checkpoint_interval(int kernels) {
+        checkpoint_interval.store(kernels);
+    }
+
+    int circuit_tasks_done() const {
+        return circuit_tasks.load();
+    }
+
+    /*
+    Вероятность имитируемого сбоя при начале задачи (до start())
+     */
+    void set_failure_probability(double probability) {
+        failure_probability = probability;
+    }
+
+    int tasks_done() const {
+        return completed_tasks.load();
+    }
+
+    // Полезная работа процессоров: время выполненных задач, умноженное
+    // на число их процессоров и занятую долю емкости
+    double busy_processor_ms() const {
+        return busy_ms.load();
+    }
+
+    // Среднее ожидание в очереди: всех задач и задач на нескольких процессорах
+    double mean_wait_ms() const {
+        int done = completed_tasks.load();
+        return done > 0 ? TscClock::instance().to_ms(total_wait_ticks.load()) / done : 0.0;
+    }
+
+    // Процессор-мс задач, прерванных началом обслуживания
+    double maintenance_lost_processor_ms() const {
+        return maintenance_lost_ms.load();
+    }
+
+    double gang_wait_ms() const {
+        int done = gang_tasks.load();
+        return done > 0 ? TscClock::instance().to_ms(gang_wait_ticks.load()) / done : 0.0;
+    }
+
+    /*
+    Ожидаемое время до начала выполнения задачи с приоритетом priority,
+    если поставить ее сейчас; O(1) от длины очереди
+    expected_ms < 0 - нет исправных процессоров, оценить нельзя
+     */
+    WaitEstimate estimate_wait(int priority, bool is_critical) const {
+        int servers = healthy_count.load() > 0 ? slots.load() : 0;
+        return wait_estimator.estimate(WaitEstimator::class_of(is_critical, priority), servers);
     }
 
     /*
     Имитация сбоя процессора с перенаправлением его задач
+    Задачи со схемами прерываются и продолжаются на другом процессоре
+    с последней контрольной точки
      */
     void processor_failure(int processor_id) {
+        EpochParticipant participant(epochs);
+        processor_failure(processor_id, participant);
+    }
+
+    void processor_failure(int processor_id, EpochParticipant& participant) {
         boost::unique_lock<boost::mutex> lock(processor_mutex);
         
         // Проверяем, не вышел ли уже процессор из строя
@@ -64,15 +269,22 @@ public:
         
         // Помечаем процессор как неисправный
         processor_status[processor_id] = false;
+        ProcessorSnapshot* previous = publish_snapshot();
+        processor_generation[processor_id]++;  // Выполняемые схемы увидят сбой
         
-        // Запоминаем количество задач для перенаправления
-        int tasks_to_redirect = processor_task_count[processor_id];
-        processor_task_count[processor_id] = 0;
+        // Запоминаем количество задач для перенаправления; задачи со схемами
+        // вернутся в очередь сами
+        // (единицы емкости не обнуляются: выполняющиеся задачи освободят их сами)
+        int tasks_to_redirect = processor_task_count[processor_id].exchange(0);
+        tasks_to_redirect = std::max(0, tasks_to_redirect - processor_circuit_count[processor_id].load());
         
         lock.unlock();
+        participant.retire(previous);
         
         std::cout << "Процессор " << processor_id << " вышел из строя. "
                   << "Перенаправление " << tasks_to_redirect << " задач...\n";
+        Tracer::instance().instant("processor_failure", "processor",
+                                   "processor", processor_id, "redirected", tasks_to_redirect);
         
         // Перенаправляем задачи обратно в общую очередь
         for (int i = 0; i < tasks_to_redirect; ++i) {
@@ -86,6 +298,7 @@ public:
     Имитация восстановления процессора
      */
     void processor_repair(int processor_id) {
+        EpochParticipant participant(epochs);
         boost::unique_lock<boost::mutex> lock(processor_mutex);
         
         // Проверяем, не работает ли уже процессор
@@ -94,10 +307,34 @@ public:
             return;
         }
         
-        // Восстанавливаем процессор
+        // Восстанавливаем процессор; на обслуживании он вернется в работу после окна
         processor_status[processor_id] = true;
-        std::cout << "Ремонт: Процессор " << processor_id << " восстановлен.\n";
+        ProcessorSnapshot* previous = publish_snapshot();
+        std::cout << "Ремонт: Процессор " << processor_id << " восстановлен"
+                  << (processor_maintenance[processor_id] > 0 ? " (на обслуживании).\n" : ".\n");
         lock.unlock();
+        participant.retire(previous);
+        Tracer::instance().instant("processor_repair", "processor", "processor", processor_id);
+    }
+
+    /*
+    Плановое обслуживание (калибровка) процессора: через start_in_ms
+    процессор останавливается на duration_ms и затем возвращается в работу
+    - drain - заранее не принимать задачи, которые по оценке длительности
+      не успеют закончиться до начала окна; иначе процессор работает до
+      окна и останавливается жестко
+    Задачи, выполняющиеся в начале окна, прерываются и возвращаются в
+    очередь (схемы - с контрольной точки)
+     */
+    void schedule_maintenance(int processor_id, double start_in_ms, double duration_ms, bool drain = true) {
+        const TscClock& clock = TscClock::instance();
+        std::uint64_t begin = TscClock::now() + clock.from_ms(start_in_ms);
+        boost::lock_guard<boost::mutex> lock(maintenance_mutex);
+        maintenance.push_back(MaintenanceWindow{processor_id, begin, begin + clock.from_ms(duration_ms), drain, false});
+        if (drain) {
+            std::uint64_t deadline = drain_deadline[processor_id].load();
+            if (deadline == 0 || begin < deadline) drain_deadline[processor_id].store(begin);
+        }
     }
 
     /*
@@ -105,21 +342,77 @@ public:
      */
     void start() {
         // Создаем 10 рабочих потоков
-        for (int i = 0; i < 10; ++i) {
-            threads.create_thread(boost::bind(&QuantumSimulator::worker_thread, this, i));
-        }
+        tasks.start(worker_count, [this](int thread_id) { worker_thread(thread_id); });
+        if (autotuner) autotuner->start();
+        maintenance_thread = boost::thread([this] { maintenance_loop(); });
+    }
+
+    /*
+    Автонастройка во время работы (до start()), период period_ms
+    - batch - задач за одно извлечение из очереди (1-8, в пределах
+      batch_budget_ms ожидаемой работы)
+    - spin - попыток уступить процессор перед засыпанием (0-256)
+    - slots - одновременно выполняемых задач (1-slot_limit(): по числу
+      процессоров, с емкостью - по числу единиц)
+    Оценка периода: выполнено задач в секунду / (1 + среднее ожидание, с)
+     */
+    void enable_autotune(int period_ms) {
+        autotuner.reset(new Autotuner(period_ms, 0.03, [this] { return measure_period(); }));
+        autotuner->add_knob("batch", batch_size.load(), 1, max_batch_size, 1,
+                            [this](int value) { batch_size.store(value); });
+        autotuner->add_knob("spin", TunableSpinIdle::spin_count().load(), 0, 256, 32,
+                            [](int value) { TunableSpinIdle::spin_count().store(value); });
+        autotuner->add_knob("slots", slots, 1, slot_limit(), 1,
+                            [this](int value) { set_slots(value); });
     }
 
     /*
     Остановка всех рабочих потоков
      */
     void stop() {
-        {
-            boost::unique_lock<boost::mutex> lock(task_mutex);
-            shutdown = true;  // Устанавливаем флаг завершения
+        if (autotuner) autotuner->stop();
+        maintenance_thread.interrupt();
+        if (maintenance_thread.joinable()) maintenance_thread.join();
+        tasks.stop();  // Флаг завершения, пробуждение и ожидание всех потоков
+
+        // Итоги по задержкам выполненных задач
+        const TscClock& clock = TscClock::instance();
+        int done = completed_tasks.load();
+        if (done > 0) {
+            std::cout << "Выполнено задач: " << done
+                      << ", среднее ожидание в очереди: " << clock.to_ms(total_wait_ticks.load()) / done << " мс"
+                      << ", максимум: " << clock.to_ms(max_wait_ticks.load()) << " мс"
+                      << ", среднее выполнение: " << clock.to_ms(total_run_ticks.load()) / done << " мс\n";
+        }
+        if (circuit_tasks > 0) {
+            std::cout << "Задач со схемами: " << circuit_tasks << ", из них на MPS: " << mps_tasks
+                      << ", одинарной точности: " << float_tasks << "\n";
+        }
+        if (gang_tasks > 0 || gang_aborts > 0) {
+            std::cout << "Задач на нескольких процессорах: " << gang_tasks
+                      << ", среднее ожидание " << (gang_tasks > 0 ? clock.to_ms(gang_wait_ticks.load()) / gang_tasks : 0.0)
+                      << " мс, прервано сбоями " << gang_aborts
+                      << " (потеряно " << gang_lost_ms << " процессор-мс), неудачных резервирований "
+                      << gang_waits << "\n";
+        }
+        if (maintenance_windows > 0) {
+            std::cout << "Окон обслуживания: " << maintenance_windows << ", прервано задач " << maintenance_aborts
+                      << " (потеряно " << maintenance_lost_ms << " процессор-мс)\n";
+        }
+        if (migrations > 0) {
+            std::cout << "Прервано сбоями: " << migrations << ", контрольных точек " << checkpoints
+                      << " (" << checkpoint_ms << " мс), на прерывание сохранено " << saved_ms / migrations
+                      << " мс вычислений, потеряно " << lost_ms / migrations << " мс\n";
+        }
+        if (estimated_tasks > 0) {
+            std::cout << "Оценка ожидания: задач " << estimated_tasks
+                      << ", средняя ошибка " << estimate_error_ms / estimated_tasks << " мс\n";
+        }
+        if (autotuner) {
+            std::cout << "Автонастройка: шагов " << autotuner->trials << ", принято " << autotuner->accepted
+                      << ", итог batch " << batch_size << ", spin " << TunableSpinIdle::spin_count()
+                      << ", slots " << slots << "\n";
         }
-        task_condition.notify_all();  // Будим все потоки
-        threads.join_all();           // Ожидаем завершения всех потоков
     }
 
 private:
@@ -130,6 +423,12 @@ private:
         int priority;       
         bool is_critical;   
         int task_id;        
+        std::uint64_t enqueued_at;  // Метка TscClock постановки в очередь
+        double estimated_ms;        // Оценка ожидания при постановке (< 0 - не было)
+        int circuit_id;             // Схема задачи, -1 - без схемы
+        int processors;             // Процессоров одновременно
+        double runtime_ms;          // Объявленная длительность, 0 - неизвестна
+        int units;                  // Единиц емкости процессора, 0 - весь процессор
 
         // Оператор сравнения для приоритетной очереди
         bool operator<(const Task& other) const {
@@ -140,147 +439,1844 @@ private:
             // Для задач равной важности сравниваем приоритеты
             return priority > other.priority;
         }
+
+        // Класс для упакованного ключа кучи, тот же порядок, что и operator<
+        std::uint64_t queue_class() const {
+            return PackedKey::make_class(is_critical, priority);
+        }
+    };
+
+    // Контрольная точка: следующее ядро и снимок состояния
+    struct Checkpoint {
+        std::size_t kernel;
+        double done_ms;      // Время вычислений до точки
+        StateVector state;          // Снимок для вектора состояния
+        StateVectorFloat single;    // Снимок для вектора одинарной точности
+        MpsState mps;               // Снимок для MPS
+    };
+
+    static StateVector& saved_state(Checkpoint& checkpoint, const StateVector&) { return checkpoint.state; }
+    static StateVectorFloat& saved_state(Checkpoint& checkpoint, const StateVectorFloat&) { return checkpoint.single; }
+    static MpsState& saved_state(Checkpoint& checkpoint, const MpsState&) { return checkpoint.mps; }
+
+    // Состояния всех представлений и матрицы ядер рабочего потока,
+    // память переиспользуется между задачами
+    struct CircuitWorkspace {
+        StateVector state;
+        StateVectorFloat single;
+        MpsState mps;
+        std::vector<StateVector::Matrix2> matrices;
+    };
+
+    // Параметры, представление и контрольная точка ожидающей задачи со схемой
+    struct CircuitJob {
+        std::vector<double> params;
+        SimulationBackend backend;
+        std::unique_ptr<Checkpoint> checkpoint;
+    };
+
+    /*
+    Постановка задачи (circuit_id = -1 - задача без схемы)
+     */
+    void submit(int priority, bool is_critical, int task_id, int circuit_id, int processors = 1,
+                double runtime_ms = 0.0, int units = 0) {
+        // Генерируем новый ID, если не указан
+        int actual_id = (task_id == -1) ? next_task_id++ : task_id;
+        
+        // Оценка ожидания на момент постановки - для сравнения с фактическим
+        double estimated_ms = estimate_wait(priority, is_critical).expected_ms;
+        
+        // Добавляем задачу в очередь диспетчера, он будит один ожидающий поток
+        wait_estimator.enqueued(WaitEstimator::class_of(is_critical, priority));
+        tasks.push(Task{priority, is_critical, actual_id, TscClock::now(), estimated_ms, circuit_id, processors,
+                        runtime_ms, units});
+    }
+
+    /*
+    Неизменяемый список исправных процессоров
+    Публикуется заново при каждом сбое и ремонте, старый удаляется
+    через эпохи, когда его не может читать ни один рабочий поток
+     */
+    struct ProcessorSnapshot {
+        std::vector<int> healthy;
     };
 
+    // Снимок по processor_status и окнам обслуживания; вызывается под processor_mutex
+    ProcessorSnapshot* make_snapshot() const {
+        ProcessorSnapshot* snapshot = new ProcessorSnapshot();
+        for (const auto& proc : processor_status) {
+            if (in_service(proc.first)) snapshot->healthy.push_back(proc.first);
+        }
+        return snapshot;
+    }
+
+    // Исправен и не на обслуживании; вызывается под processor_mutex
+    bool in_service(int processor_id) const {
+        return processor_status.at(processor_id) && processor_maintenance[processor_id] == 0;
+    }
+
+    /*
+    Замена снимка; вызывается под processor_mutex
+    Возвращает прежний снимок - его передают в retire только после
+    освобождения processor_mutex: retire может ждать читателей, а читатель
+    вне эпохи берет backfill_mutex, под которым ждут processor_mutex
+     */
+    ProcessorSnapshot* publish_snapshot() {
+        ProcessorSnapshot* snapshot = make_snapshot();
+        healthy_count.store(static_cast<int>(snapshot->healthy.size()));
+        return healthy_processors.exchange(snapshot);
+    }
+
     /*
     Функция рабочего потока
      */
     void worker_thread(int thread_id) {
         // Генераторы случайных чисел для потока
         std::mt19937 gen(std::time(0) + thread_id);
-        std::bernoulli_distribution failure_dist(0.1);  // 10% вероятность сбоя
+        std::bernoulli_distribution failure_dist(failure_probability);  // Вероятность сбоя при начале задачи
+        Tracer::instance().name_thread("worker " + std::to_string(thread_id));
+        EpochParticipant participant(epochs);
         
-        while (!shutdown) {
-            Task current_task;
-            
-            // Получаем задачу из общей очереди
-            {
-                boost::unique_lock<boost::mutex> lock(task_mutex);
-                
-                // Ожидаем появления задач или сигнала завершения
-                while (tasks.empty() && !shutdown) {
-                    task_condition.wait(lock);
+        std::vector<Task> batch;
+        batch.reserve(max_batch_size);
+        
+        // Состояния и матрицы ядер для задач со схемами
+        CircuitWorkspace workspace;
+
+        // Берем до batch_size задач с наивысшим приоритетом, ожидая их появления,
+        // но не больше batch_budget_ms ожидаемой работы: длинные задачи берутся
+        // по одной и не задерживают более приоритетные и остановку
+        // false - сигнал завершения работы
+        auto cost = [this](const Task& task) { return runtime_estimate(task); };
+        while (tasks.pop_batch(batch, batch_size.load(), cost, batch_budget_ms)) {
+            for (const Task& task : batch) wait_estimator.taken(WaitEstimator::class_of(task.is_critical, task.priority));
+            for (Task& current_task : batch) {
+                // При остановке оставшиеся задачи пакета не начинаем
+                if (tasks.stopping()) break;
+
+                // Захватываем слот в семафоре (получаем доступ к процессору)
+                tasks.acquire();
+
+                // Задача на нескольких процессорах - отдельный путь с резервированием
+                // (частые попытки резервирования не вызывают имитируемых сбоев)
+                if (current_task.processors > 1) {
+                    bool started = run_gang_task(current_task, thread_id, gen);
+                    tasks.release();
+                    if (!started) boost::this_thread::sleep_for(boost::chrono::milliseconds(20));
+                    continue;
                 }
-                
-                // Проверяем, не пора ли завершать работу
-                if (shutdown) break;
-                
-                // Берем задачу с наивысшим приоритетом
-                current_task = tasks.top();
-                tasks.pop();
-            }
 
-            // Захватываем слот в семафоре (получаем доступ к процессору)
-            task_semaphore.wait();
+                // С вероятностью 10% (failure_probability) вызываем сбой случайного процессора
+                if (failure_dist(gen)) {
+                    int processor_to_fail = std::rand() % 4;  // Случайный процессор 0-3
+                    processor_failure(processor_to_fail, participant);
+                }
 
-            // С вероятностью 10% вызываем сбой случайного процессора
-            if (failure_dist(gen)) {
-                int processor_to_fail = std::rand() % 4;  // Случайный процессор 0-3
-                processor_failure(processor_to_fail);
-            }
+                // Поколения процессоров до чтения снимка: сбой после этого
+                // момента задача обнаружит по смене поколения
+                int generations[4], services[4];
+                for (int i = 0; i < 4; ++i) {
+                    generations[i] = processor_generation[i].load();
+                    services[i] = maintenance_epoch[i].load();
+                }
 
-            // Выбираем процессор для выполнения задачи
-            int processor_id = -1;
-            {
-                boost::unique_lock<boost::mutex> lock(processor_mutex);
-                std::vector<int> available_processors;
+                // Выбираем процессор для выполнения задачи по снимку исправных
+                // Внутри эпохи только копируем снимок - без блокировок; проверки
+                // режима планирования и дома схемы (backfill_mutex, circuits_mutex)
+                // идут уже вне эпохи
+                int healthy_ids[4];
+                int healthy_total = 0;
+                {
+                    EpochGuard guard(participant);
+                    const ProcessorSnapshot* snapshot = healthy_processors.load();
+                    for (int healthy : snapshot->healthy) healthy_ids[healthy_total++] = healthy;
+                }
+                participant.collect();
+
+                int processor_id = -1;
+                int units = units_of(current_task);
+                {
+                    // Исправные процессоры без резервирования задачами на нескольких
+                    // процессорах, разрешенные режимом планирования; из них свободные
+                    // (первыми - те, что скоро уходят на обслуживание и задача успевает)
+                    // и, для малых задач, самые заполненные, где задача помещается
+                    int open[4], idle[4], packed[4];
+                    int open_count = 0, idle_count = 0, packed_count = 0, packed_used = 0, draining_count = 0;
+                    for (int k = 0; k < healthy_total; ++k) {
+                        int healthy = healthy_ids[k];
+                        if (processor_reserved[healthy].load()) continue;
+                        if (!may_start(current_task, &healthy, 1)) continue;
+                        if (!finishes_before_maintenance(healthy, current_task)) continue;
+                        if (!has_room(healthy, units)) continue;
+                        open[open_count++] = healthy;
+                        if (processor_task_count[healthy].load() == 0) {
+                            idle[idle_count++] = healthy;
+                            if (drain_deadline[healthy].load() != 0) std::swap(idle[draining_count++], idle[idle_count - 1]);
+                        }
+                        int used = processor_units[healthy].load();
+                        if (used > 0 && used + units <= processor_capacity) {
+                            if (used > packed_used) packed_count = 0;
+                            if (used >= packed_used) {
+                                packed_used = used;
+                                packed[packed_count++] = healthy;
+                            }
+                        }
+                    }
                 
-                // Собираем список исправных процессоров
-                for (const auto& proc : processor_status) {
-                    if (proc.second) {  // Если процессор исправен
-                        available_processors.push_back(proc.first);
+                    // Если есть доступные процессоры
+                    if (open_count > 0) {
+                        // Задачи схемы - на процессор, где она уже выполнялась (если на нем
+                        // есть место), малые - к другим малым, иначе выбираем случайный процессор,
+                        // свободный, если есть - так задачам на нескольких процессорах
+                        // и обычным задачам остаются свободные
+                        int home = current_task.circuit_id >= 0 ? home_of(current_task.circuit_id) : -1;
+                        for (int i = 0; i < open_count; ++i) {
+                            if (open[i] == home) processor_id = home;
+                        }
+                        if (processor_id == -1) {
+                            const int* pool = packed_count > 0 ? packed : idle_count > 0 ? idle : open;
+                            int pool_count = packed_count > 0 ? packed_count
+                                           : draining_count > 0 ? draining_count
+                                           : idle_count > 0 ? idle_count : open_count;
+                            std::uniform_int_distribution<> dist(0, pool_count - 1);
+                            processor_id = pool[dist(gen)];
+                            if (current_task.circuit_id >= 0) set_home(current_task.circuit_id, processor_id);
+                        }
+                    
+                        // Занимаем единицы емкости и увеличиваем счетчик задач выбранного
+                        // процессора; если места нет или его успели зарезервировать,
+                        // отступаем (см. reserve_processors). Схема учитывается до
+                        // счетчика задач: сбой с этого момента не перенаправит ее
+                        // как обычную задачу, она сама вернется в очередь
+                        if (!take_units(processor_id, units)) {
+                            processor_id = -1;
+                        } else {
+                            if (current_task.circuit_id >= 0) processor_circuit_count[processor_id]++;
+                            processor_task_count[processor_id]++;
+                            if (processor_reserved[processor_id].load()) {
+                                release_processor(processor_id, units);
+                                if (current_task.circuit_id >= 0) processor_circuit_count[processor_id]--;
+                                processor_id = -1;
+                            }
+                        }
                     }
                 }
+
+                // Если нет доступных процессоров
+                if (processor_id == -1) {
+                    std::cout << "[ОЖИДАНИЕ] Нет доступных процессоров. Задача " 
+                              << current_task.task_id << " (приоритет: " << current_task.priority 
+                              << ", критическая: " << current_task.is_critical 
+                              << ") возвращена в очередь.\n";
+                    Tracer::instance().instant("requeue", "worker", "task", current_task.task_id);
                 
-                // Если есть доступные процессоры
-                if (!available_processors.empty()) {
-                    // Выбираем случайный процессор
-                    std::uniform_int_distribution<> dist(0, available_processors.size() - 1);
-                    processor_id = available_processors[dist(gen)];
-                    
-                    // Увеличиваем счетчик задач для выбранного процессора
-                    processor_task_count[processor_id]++;
+                    // Возвращаем задачу в общую очередь
+                    wait_estimator.returned(WaitEstimator::class_of(current_task.is_critical, current_task.priority));
+                    tasks.push(current_task);
+                
+                    tasks.release();  // Освобождаем слот
+                    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+                    continue;
                 }
-            }
 
-            // Если нет доступных процессоров
-            if (processor_id == -1) {
-                std::cout << "[ОЖИДАНИЕ] Нет доступных процессоров. Задача " 
-                          << current_task.task_id << " (приоритет: " << current_task.priority 
+                mark_busy(processor_id, current_task);
+
+                // Выводим информацию о выполняемой задаче
+                std::cout << "Поток " << thread_id << " выполняет задачу " << current_task.task_id 
+                          << " (приоритет: " << current_task.priority 
                           << ", критическая: " << current_task.is_critical 
-                          << ") возвращена в очередь.\n";
-                
-                // Возвращаем задачу в общую очередь
+                          << ") на процессоре " << processor_id << "\n";
+
+                // Время ожидания в очереди (с учетом возвратов в очередь)
+                std::uint64_t dispatched_at = TscClock::now();
+                std::uint64_t wait_ticks = task_started(current_task, dispatched_at);
+
+                // Задача со схемой выполняется на векторе состояния,
+                // остальные имитируют обработку (случайное время 500-1500 мс)
+                bool completed = true;
                 {
-                    boost::unique_lock<boost::mutex> lock(task_mutex);
+                    TraceScope trace("task", "worker");
+                    trace.arg("task", current_task.task_id);
+                    trace.arg("processor", processor_id);
+                    trace.arg("priority", current_task.priority);
+                    trace.arg("critical", current_task.is_critical);
+                    trace.arg("wait_us", static_cast<std::int64_t>(TscClock::instance().to_us(wait_ticks)));
+
+                    if (current_task.circuit_id >= 0) {
+                        completed = run_circuit_task(current_task, processor_id, generations[processor_id], workspace);
+                    } else {
+                        // Частями по 50 мс: начало обслуживания прерывает задачу
+                        std::uniform_int_distribution<> work_dist(500, 1500);
+                        int remaining = current_task.runtime_ms > 0 ? static_cast<int>(current_task.runtime_ms) : work_dist(gen);
+                        while (remaining > 0) {
+                            if (maintenance_epoch[processor_id].load() != services[processor_id]) {
+                                completed = false;
+                                break;
+                            }
+                            int step = std::min(remaining, 50);
+                            boost::this_thread::sleep_for(boost::chrono::milliseconds(step));
+                            remaining -= step;
+                        }
+                    }
+                }
+
+                std::uint64_t run_ticks = TscClock::now() - dispatched_at;
+                if (!completed && current_task.circuit_id < 0) {
+                    maintenance_aborts++;
+                    add_ms(maintenance_lost_ms, TscClock::instance().to_ms(run_ticks) * share_of(units));
+                }
+                if (completed) {
+                    wait_estimator.finished(TscClock::instance().to_ms(run_ticks));
+                    record_latency(wait_ticks, run_ticks, 1, share_of(units));
+                } else {
+                    // Процессор отказал или ушел на обслуживание - задача снова
+                    // в очереди, схема продолжится с контрольной точки
+                    wait_estimator.migrated(WaitEstimator::class_of(current_task.is_critical, current_task.priority));
                     tasks.push(current_task);
                 }
-                
-                task_semaphore.post();  // Освобождаем слот
-                boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+
+                // После выполнения задачи уменьшаем счетчик задач процессора
+                release_processor(processor_id, units);
+                if (current_task.circuit_id >= 0) processor_circuit_count[processor_id]--;
+                if (processor_task_count[processor_id].load() == 0) busy_until[processor_id].store(0);
+
+                // Освобождаем слот в семафоре
+                tasks.release();
+            }
+        }
+    }
+
+    /*
+    Начало выполнения задачи: учет в оценке ожидания и ее ошибки
+    Возвращает время ожидания в очереди (с учетом возвратов в очередь)
+     */
+    std::uint64_t task_started(const Task& task, std::uint64_t dispatched_at) {
+        std::uint64_t wait_ticks = dispatched_at - task.enqueued_at;
+        wait_estimator.started();
+        if (task.estimated_ms >= 0) {
+            add_ms(estimate_error_ms, std::fabs(TscClock::instance().to_ms(wait_ticks) - task.estimated_ms));
+            estimated_tasks++;
+        }
+        return wait_ticks;
+    }
+
+    // Уменьшение счетчика задач процессора (после сбоя счетчик уже обнулен)
+    void release_processor(int processor_id, int units) {
+        int count = processor_task_count[processor_id].load();
+        while (count > 0 && !processor_task_count[processor_id].compare_exchange_weak(count, count - 1)) {
+        }
+        int used = processor_units[processor_id].load();
+        while (used > 0 && !processor_units[processor_id].compare_exchange_weak(used, std::max(0, used - units))) {
+        }
+    }
+
+    // Единиц емкости задачи на процессоре
+    // (0 - емкость не учитывается)
+    int units_of(const Task& task) const {
+        return task.units > 0 ? std::min(task.units, processor_capacity) : processor_capacity;
+    }
+
+    // Доля процессора, занятая задачей
+    double share_of(int units) const {
+        return processor_capacity > 0 ? static_cast<double>(units) / processor_capacity : 1.0;
+    }
+
+    bool has_room(int processor_id, int units) const {
+        return processor_capacity == 0 || processor_units[processor_id].load() + units <= processor_capacity;
+    }
+
+    // Занять units единиц, если на процессоре есть место
+    bool take_units(int processor_id, int units) {
+        if (processor_capacity == 0) return true;
+        int used = processor_units[processor_id].load();
+        while (used + units <= processor_capacity) {
+            if (processor_units[processor_id].compare_exchange_weak(used, used + units)) return true;
+        }
+        return false;
+    }
+
+    /*
+    Резервирование count свободных исправных процессоров: все или ничего
+    - Под processor_mutex, поэтому резервирования не пересекаются, а
+      частично зарезервированных наборов не бывает - задачи на нескольких
+      процессорах не ждут друг друга и не могут взаимно заблокироваться
+    - Одиночные задачи берут процессор без мьютекса: сначала увеличивают
+      счетчик, потом проверяют резерв; резервирование - наоборот, поэтому
+      хотя бы одна сторона видит другую и отступает
+    ids и generations - номера и поколения зарезервированных процессоров
+     */
+    bool reserve_processors(int count, int* ids, int* generations) {
+        boost::lock_guard<boost::mutex> lock(processor_mutex);
+        int found = 0;
+        for (const auto& proc : processor_status) {
+            int id = proc.first;
+            if (found == count) break;
+            if (!in_service(id) || processor_reserved[id].load()) continue;
+            processor_reserved[id].store(true);
+            if (processor_task_count[id].load() > 0) {
+                processor_reserved[id].store(false);
                 continue;
             }
+            ids[found] = id;
+            generations[found] = processor_generation[id].load();
+            found++;
+        }
+        if (found < count) {
+            for (int i = 0; i < found; ++i) processor_reserved[ids[i]].store(false);
+            return false;
+        }
+        return true;
+    }
+
+    void release_processors(int count, const int* ids) {
+        boost::lock_guard<boost::mutex> lock(processor_mutex);
+        for (int i = 0; i < count; ++i) processor_reserved[ids[i]].store(false);
+    }
+
+    /*
+    Успеет ли задача закончиться на процессоре до ближайшего окна
+    обслуживания с заблаговременным освобождением
+     */
+    bool finishes_before_maintenance(int processor_id, const Task& task) const {
+        std::uint64_t deadline = drain_deadline[processor_id].load();
+        return deadline == 0 || TscClock::now() + TscClock::instance().from_ms(runtime_estimate(task)) <= deadline;
+    }
+
+    /*
+    Поток обслуживания: каждые 10 мс начинает и заканчивает окна
+    - Начало: процессор на обслуживании (отдельно от сбоя, processor_status
+      не меняется) и не выбирается, поколение и эпоха обслуживания растут -
+      выполняющиеся задачи прерываются сами
+    - Конец: процессор снова выбирается, если исправен; срок освобождения -
+      следующее окно
+     */
+    void maintenance_loop() {
+        EpochParticipant participant(epochs);
+        while (!boost::this_thread::interruption_requested()) {
+            try {
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+            } catch (const boost::thread_interrupted&) {
+                break;
+            }
+            std::uint64_t now = TscClock::now();
+            boost::lock_guard<boost::mutex> lock(maintenance_mutex);
+            for (std::size_t i = 0; i < maintenance.size();) {
+                MaintenanceWindow& window = maintenance[i];
+                if (!window.begun && now >= window.start) {
+                    window.begun = true;
+                    begin_maintenance(window.processor, participant);
+                }
+                if (window.begun && now >= window.end) {
+                    end_maintenance(window.processor, participant);
+                    maintenance.erase(maintenance.begin() + i);
+                    continue;
+                }
+                ++i;
+            }
+            participant.collect();
+        }
+    }
+
+    void begin_maintenance(int processor_id, EpochParticipant& participant) {
+        ProcessorSnapshot* previous;
+        {
+            boost::lock_guard<boost::mutex> lock(processor_mutex);
+            processor_maintenance[processor_id]++;
+            previous = publish_snapshot();
+            processor_generation[processor_id]++;
+            maintenance_epoch[processor_id]++;
+        }
+        participant.retire(previous);
+        maintenance_windows++;
+        std::cout << "Обслуживание: процессор " << processor_id << " остановлен.\n";
+        Tracer::instance().instant("maintenance_begin", "processor", "processor", processor_id);
+    }
+
+    // Вызывается под maintenance_mutex
+    void end_maintenance(int processor_id, EpochParticipant& participant) {
+        std::uint64_t next = 0;
+        for (const MaintenanceWindow& window : maintenance) {
+            if (window.processor == processor_id && window.drain && !window.begun && (next == 0 || window.start < next)) {
+                next = window.start;
+            }
+        }
+        drain_deadline[processor_id].store(next);
+        bool failed;
+        ProcessorSnapshot* previous;
+        {
+            boost::lock_guard<boost::mutex> lock(processor_mutex);
+            processor_maintenance[processor_id]--;
+            previous = publish_snapshot();
+            failed = !processor_status[processor_id];
+        }
+        participant.retire(previous);
+        // Сбой до или во время окна обслуживание не исправляет - нужен ремонт
+        std::cout << "Обслуживание: процессор " << processor_id
+                  << (failed ? " закончил обслуживание, но неисправен.\n" : " снова работает.\n");
+        Tracer::instance().instant("maintenance_end", "processor", "processor", processor_id);
+    }
 
-            // Выводим информацию о выполняемой задаче
-            std::cout << "Поток " << thread_id << " выполняет задачу " << current_task.task_id 
-                      << " (приоритет: " << current_task.priority 
-                      << ", критическая: " << current_task.is_critical 
-                      << ") на процессоре " << processor_id << "\n";
+    /*
+    Оценка длительности: объявленная или изученная для задач того же
+    числа процессоров
+     */
+    double runtime_estimate(const Task& task) const {
+        return task.runtime_ms > 0 ? task.runtime_ms : learned_runtime_ms[task.processors].load();
+    }
 
-            // Имитируем обработку задачи (случайное время 500-1500 мс)
-            std::uniform_int_distribution<> work_dist(500, 1500);
-            boost::this_thread::sleep_for(boost::chrono::milliseconds(work_dist(gen)));
+    // Ожидаемое время освобождения процессора начатой на нем задачей
+    void mark_busy(int processor_id, const Task& task) {
+        std::uint64_t until = TscClock::now() + TscClock::instance().from_ms(runtime_estimate(task));
+        std::uint64_t current = busy_until[processor_id].load();
+        while (until > current && !busy_until[processor_id].compare_exchange_weak(current, until)) {
+        }
+    }
+
+    /*
+    Может ли задача начаться сейчас на процессорах ids (count номеров)
+    Greedy - всегда; иначе, если ждет старшая задача на нескольких
+    процессорах (head), Strict - только задача важнее ее, Backfill - если
+    задача не займет процессоры head дольше момента head_shadow
+     */
+    bool may_start(const Task& task, const int* ids, int count) {
+        if (scheduling == SchedulingMode::Greedy) return true;
+        boost::lock_guard<boost::mutex> lock(backfill_mutex);
+        if (!head_active || head_task.task_id == task.task_id || head_task < task) return true;
+        if (scheduling == SchedulingMode::Strict) return false;
+        std::uint64_t finish = TscClock::now() + TscClock::instance().from_ms(runtime_estimate(task));
+        for (int i = 0; i < count; ++i) {
+            if ((head_processors & (1u << ids[i])) && finish > head_shadow) return false;
+        }
+        return true;
+    }
+
+    /*
+    Задача на нескольких процессорах не смогла начаться: становится
+    ожидающей (head), если важнее текущей; момент shadow и процессоры
+    head пересчитываются при каждой попытке по ожидаемым освобождениям
+     */
+    void wait_for_processors(const Task& task) {
+        if (scheduling == SchedulingMode::Greedy) return;
+        boost::lock_guard<boost::mutex> lock(backfill_mutex);
+        if (head_active && head_task.task_id != task.task_id && !(head_task < task)) return;
+
+        // (время освобождения, процессор) исправных процессоров
+        std::uint64_t now = TscClock::now();
+        std::vector<std::pair<std::uint64_t, int>> free_at;
+        {
+            boost::lock_guard<boost::mutex> processors_lock(processor_mutex);
+            for (const auto& proc : processor_status) {
+                if (!in_service(proc.first)) continue;
+                bool idle = processor_task_count[proc.first].load() == 0 && !processor_reserved[proc.first].load();
+                free_at.push_back(std::make_pair(idle ? now : std::max(now, busy_until[proc.first].load()), proc.first));
+            }
+        }
+        std::sort(free_at.begin(), free_at.end());
+
+        head_active = true;
+        head_task = task;
+        head_processors = 0;
+        if (static_cast<int>(free_at.size()) < task.processors) {
+            // Исправных не хватает - ждать ремонта, остальным не мешать
+            head_shadow = ~std::uint64_t(0);
+            return;
+        }
+        head_shadow = free_at[task.processors - 1].first;
+        for (int i = 0; i < task.processors; ++i) head_processors |= 1u << free_at[i].second;
+    }
+
+    void started_as_head(const Task& task) {
+        boost::lock_guard<boost::mutex> lock(backfill_mutex);
+        if (head_active && head_task.task_id == task.task_id) head_active = false;
+    }
+
+    /*
+    Число процессоров задачи: не больше 4 и не больше слотов семафора -
+    иначе резервирование или захват слотов не удастся никогда и задача
+    будет возвращаться в очередь бесконечно
+     */
+    int gang_size(int processors) const {
+        return std::max(1, std::min(processors, std::min(4, slots.load())));
+    }
 
-            // После выполнения задачи уменьшаем счетчик задач процессора
-            {
-                boost::unique_lock<boost::mutex> lock(processor_mutex);
-                if (processor_task_count[processor_id] > 0) {
-                    processor_task_count[processor_id]--;
+    /*
+    Задача на task.processors процессорах
+    - Занимает по слоту семафора на процессор: свой слот вызывающего
+      и processors - 1 дополнительных, захваченных без ожидания
+    - Если столько свободных процессоров или слотов нет, задача возвращается
+      в очередь (false - вызывающий ждет перед следующей попыткой)
+    - Сбой любого из процессоров прерывает задачу на всех; резерв снимается,
+      задача возвращается в очередь и начинается заново
+     */
+    bool run_gang_task(const Task& task, int thread_id, std::mt19937& gen) {
+        int ids[4];
+        int generations[4];
+        int count = gang_size(task.processors);  // Слотов могло стать меньше после постановки
+        int extra_slots = 0;
+        bool reserved = reserve_processors(count, ids, generations);
+        while (reserved && extra_slots < count - 1 && tasks.try_acquire()) extra_slots++;
+        bool allowed = reserved && extra_slots == count - 1 && may_start(task, ids, count);
+        for (int i = 0; allowed && i < count; ++i) allowed = finishes_before_maintenance(ids[i], task);
+        if (!allowed) {
+            for (int i = 0; i < extra_slots; ++i) tasks.release();
+            if (reserved) release_processors(count, ids);
+            wait_for_processors(task);
+            gang_waits++;
+            wait_estimator.returned(WaitEstimator::class_of(task.is_critical, task.priority));
+            tasks.push(task);
+            return false;
+        }
+
+        std::cout << "Поток " << thread_id << " выполняет задачу " << task.task_id
+                  << " (приоритет: " << task.priority << ", критическая: " << task.is_critical
+                  << ") на процессорах";
+        for (int i = 0; i < count; ++i) std::cout << " " << ids[i];
+        std::cout << "\n";
+
+        started_as_head(task);
+        for (int i = 0; i < count; ++i) mark_busy(ids[i], task);
+        std::uint64_t dispatched_at = TscClock::now();
+        std::uint64_t wait_ticks = task_started(task, dispatched_at);
+
+        // Имитация работы частями по 50 мс с проверкой поколений процессоров
+        bool completed = true;
+        {
+            TraceScope trace("gang_task", "worker");
+            trace.arg("task", task.task_id);
+            trace.arg("processors", count);
+            std::uniform_int_distribution<> work_dist(500, 1500);
+            int remaining = task.runtime_ms > 0 ? static_cast<int>(task.runtime_ms) : work_dist(gen);
+            while (remaining > 0 && completed) {
+                int step = std::min(remaining, 50);
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(step));
+                remaining -= step;
+                for (int i = 0; i < count; ++i) {
+                    if (processor_generation[ids[i]].load() != generations[i]) completed = false;
                 }
             }
+        }
+        for (int i = 0; i < count; ++i) busy_until[ids[i]].store(0);
+        release_processors(count, ids);
+        for (int i = 0; i < extra_slots; ++i) tasks.release();
+
+        std::uint64_t run_ticks = TscClock::now() - dispatched_at;
+        if (completed) {
+            gang_tasks++;
+            gang_wait_ticks += wait_ticks;
+            wait_estimator.finished(TscClock::instance().to_ms(run_ticks));
+            record_latency(wait_ticks, run_ticks, count);
+        } else {
+            std::cout << "Задача " << task.task_id << ": сбой одного из процессоров, снята со всех "
+                      << count << " и возвращена в очередь\n";
+            gang_aborts++;
+            add_ms(gang_lost_ms, TscClock::instance().to_ms(run_ticks) * count);
+            wait_estimator.migrated(WaitEstimator::class_of(task.is_critical, task.priority));
+            tasks.push(task);
+        }
+        return true;
+    }
+
+    /*
+    Запуск схемы задачи: привязка параметров к скомпилированной схеме
+    и выполнение на выбранном при постановке представлении
+    false - процессор отказал, задача с контрольной точкой ждет продолжения
+     */
+    bool run_circuit_task(const Task& task, int processor_id, int generation, CircuitWorkspace& workspace) {
+        std::shared_ptr<const CompiledCircuit> circuit;
+        std::shared_ptr<const std::vector<PauliString>> observable;
+        CircuitJob job;
+        {
+            boost::lock_guard<boost::mutex> lock(circuits_mutex);
+            circuit = circuits[task.circuit_id];
+            observable = observables[task.circuit_id];
+            std::map<int, CircuitJob>::iterator found = circuit_jobs.find(task.task_id);
+            job = std::move(found->second);
+            circuit_jobs.erase(found);
+        }
+
+        bool completed;
+        std::vector<StateVector::Matrix2>& matrices = workspace.matrices;
+        switch (job.backend) {
+        case SimulationBackend::Mps:
+            workspace.mps.set_max_bond(mps_bond.load());
+            completed = run_with_checkpoints(*circuit, job, workspace.mps, matrices, processor_id, generation);
+            break;
+        case SimulationBackend::StateVectorFloat:
+            completed = run_with_checkpoints(*circuit, job, workspace.single, matrices, processor_id, generation);
+            break;
+        default:
+            completed = run_with_checkpoints(*circuit, job, workspace.state, matrices, processor_id, generation);
+            break;
+        }
 
-            // Освобождаем слот в семафоре
-            task_semaphore.post();
+        if (!completed) {
+            std::cout << "Задача " << task.task_id << ": процессор " << processor_id << " отказал, продолжение с ядра "
+                      << (job.checkpoint ? job.checkpoint->kernel : 0) << " из " << circuit->kernels() << "\n";
+            boost::lock_guard<boost::mutex> lock(circuits_mutex);
+            circuit_jobs[task.task_id] = std::move(job);
+            return false;
+        }
+
+        circuit_tasks++;
+        switch (job.backend) {
+        case SimulationBackend::Mps:
+            mps_tasks++;
+            report_circuit_task(task, workspace.mps, *observable);
+            std::cout << "  MPS: связь " << workspace.mps.bond_dimension() << " из " << workspace.mps.max_bond()
+                      << ", отброшенный вес " << workspace.mps.discarded_weight() << "\n";
+            break;
+        case SimulationBackend::StateVectorFloat:
+            float_tasks++;
+            report_circuit_task(task, workspace.single, *observable);
+            break;
+        default:
+            report_circuit_task(task, workspace.state, *observable);
+            break;
+        }
+        return true;
+    }
+
+    /*
+    Выполнение схемы по одному ядру с проверкой поколения процессора
+    - Начало с контрольной точки задания, если она есть
+    - Каждые checkpoint_interval ядер - снимок состояния в задание
+    - Смена поколения (сбой) - выход; работа после последней точки потеряна
+     */
+    template <typename State>
+    bool run_with_checkpoints(const CompiledCircuit& circuit, CircuitJob& job, State& state,
+                              std::vector<StateVector::Matrix2>& matrices, int processor_id, int generation) {
+        const TscClock& clock = TscClock::instance();
+        circuit.bind(job.params.data(), matrices);
+        std::size_t kernel = 0;
+        double done_ms = 0.0;  // Вычисления до последней точки
+        if (job.checkpoint) {
+            std::uint64_t begin = TscClock::now();
+            kernel = job.checkpoint->kernel;
+            done_ms = job.checkpoint->done_ms;
+            state = saved_state(*job.checkpoint, state);
+            add_ms(checkpoint_ms, clock.to_ms(TscClock::now() - begin));
+        } else {
+            state.reset(circuit.qubits());
+        }
+
+        const std::size_t interval = static_cast<std::size_t>(checkpoint_interval.load());
+        std::uint64_t since = TscClock::now();  // Начало работы после последней точки
+        while (kernel < circuit.kernels()) {
+            circuit.execute(state, matrices, kernel, kernel + 1);
+            ++kernel;
+            if (processor_generation[processor_id].load() != generation) {
+                migrations++;
+                add_ms(lost_ms, clock.to_ms(TscClock::now() - since));
+                add_ms(saved_ms, done_ms);
+                return false;
+            }
+            if (interval > 0 && kernel % interval == 0 && kernel < circuit.kernels()) {
+                std::uint64_t begin = TscClock::now();
+                done_ms += clock.to_ms(begin - since);
+                if (!job.checkpoint) job.checkpoint.reset(new Checkpoint());
+                job.checkpoint->kernel = kernel;
+                job.checkpoint->done_ms = done_ms;
+                saved_state(*job.checkpoint, state) = state;
+                since = TscClock::now();
+                add_ms(checkpoint_ms, clock.to_ms(since - begin));
+                checkpoints++;
+            }
+        }
+        return true;
+    }
+
+    template <typename State>
+    void report_circuit_task(const Task& task, const State& state, const std::vector<PauliString>& observable) {
+        std::cout << "Задача " << task.task_id << ": схема " << task.circuit_id << " (" << state.qubits() << " кубитов)";
+        if (observable.empty()) {
+            std::cout << ", <Z0> = " << state.expectation_z(0) << "\n";
+        } else {
+            std::cout << ", энергия " << pauli_energy(state, observable) << "\n";
+        }
+    }
+
+    int home_of(int circuit_id) {
+        boost::lock_guard<boost::mutex> lock(circuits_mutex);
+        return circuit_home[circuit_id];
+    }
+
+    void set_home(int circuit_id, int processor_id) {
+        boost::lock_guard<boost::mutex> lock(circuits_mutex);
+        circuit_home[circuit_id] = processor_id;
+    }
+
+    /*
+    Оценка работы с прошлого вызова (вызывает только автонастройка)
+     */
+    double measure_period() {
+        std::uint64_t now = TscClock::now();
+        int done = completed_tasks.load();
+        std::uint64_t wait = total_wait_ticks.load();
+        const TscClock& clock = TscClock::instance();
+
+        double seconds = clock.to_ms(now - measured_at) / 1000.0;
+        int finished = done - measured_done;
+        double mean_wait = finished > 0 ? clock.to_ms(wait - measured_wait) / 1000.0 / finished : 0.0;
+        measured_at = now;
+        measured_done = done;
+        measured_wait = wait;
+        return seconds > 0 ? finished / seconds / (1.0 + mean_wait) : 0.0;
+    }
+
+    /*
+    Изменение числа слотов семафора (из потока автонастройки)
+    Уменьшение ждет, пока освободится занятый слот
+     */
+    void set_slots(int value) {
+        for (; slots < value; ++slots) tasks.release();
+        for (; slots > value; --slots) tasks.acquire();
+    }
+
+    // Сложение для std::atomic<double>
+    static void add_ms(std::atomic<double>& total, double value) {
+        double sum = total.load();
+        while (!total.compare_exchange_weak(sum, sum + value)) {
+        }
+    }
+
+    /*
+    Учет задержек выполненной задачи (в тиках TscClock)
+    share - доля емкости процессора, занятая задачей
+     */
+    void record_latency(std::uint64_t wait_ticks, std::uint64_t run_ticks, int processors = 1, double share = 1.0) {
+        completed_tasks++;
+        double run_ms = TscClock::instance().to_ms(run_ticks);
+        add_ms(busy_ms, run_ms * processors * share);
+
+        // Изученная длительность - скользящее среднее по числу процессоров
+        std::atomic<double>& learned = learned_runtime_ms[processors];
+        double mean = learned.load();
+        while (!learned.compare_exchange_weak(mean, mean + 0.2 * (run_ms - mean))) {
+        }
+        total_wait_ticks += wait_ticks;
+        total_run_ticks += run_ticks;
+        std::uint64_t max_wait = max_wait_ticks.load();
+        while (wait_ticks > max_wait && !max_wait_ticks.compare_exchange_weak(max_wait, wait_ticks)) {
         }
     }
 
 private:
-    // Семафор для ограничения одновременных задач
-    boost::interprocess::interprocess_semaphore task_semaphore;
+    // Диспетчер: 4-арная куча упакованных ключей задач, рабочие потоки
+    // и семафор для ограничения одновременных задач
+    Dispatcher<Task, PackedQueuePolicy<Task, 4>, TunableSpinIdle, 4> tasks;
     
-    // Приоритетная очередь задач
-    std::priority_queue<Task> tasks;
+    // Мьютекс для изменения статусов процессоров
+    boost::mutex processor_mutex;
     
-    // Группа рабочих потоков
-    boost::thread_group threads;
+    // Статусы процессоров (true - исправен, false - сломан)
+    std::map<int, bool> processor_status;
     
-    // Мьютексы для синхронизации
-    boost::mutex task_mutex;         // Для доступа к общей очереди задач
-    boost::mutex processor_mutex;    // Для доступа к статусам процессоров
+    // Счетчики задач на каждом процессоре, из них со схемами
+    std::atomic<int> processor_task_count[4];
+    std::atomic<int> processor_units[4];          // Занятые единицы емкости
     
-    // Условная переменная для ожидания задач
-    boost::condition_variable task_condition;
+    // Плановое обслуживание процессоров
+    struct MaintenanceWindow {
+        int processor;
+        std::uint64_t start, end;   // TscClock
+        bool drain;
+        bool begun;
+    };
+    boost::mutex maintenance_mutex;
+    std::vector<MaintenanceWindow> maintenance;
+    boost::thread maintenance_thread;
+    int processor_maintenance[4];                   // Идущих окон процессора, под processor_mutex
+    std::atomic<std::uint64_t> drain_deadline[4];   // Начало ближайшего окна с освобождением, 0 - нет
+    std::atomic<int> maintenance_epoch[4];          // Растет в начале окна
+    std::atomic<int> maintenance_windows{0};
+    std::atomic<int> maintenance_aborts{0};         // Прервано задач без схем
+    std::atomic<double> maintenance_lost_ms{0.0};   // Процессор-мс прерванных задач
+    int processor_capacity = 0;                   // Единиц емкости процессора, 0 - без учета
+    static const int max_processor_capacity = 8;
+    std::atomic<int> processor_circuit_count[4];
     
-    // Статусы процессоров (true - исправен, false - сломан)
-    std::map<int, bool> processor_status;
+    // Поколение процессора: растет при каждом сбое
+    std::atomic<int> processor_generation[4];
     
-    // Счетчики задач на каждом процессоре
-    std::map<int, int> processor_task_count;
+    // Вероятность сбоя случайного процессора при начале задачи
+    double failure_probability = 0.1;
     
-    // Флаг для остановки потоков
-    std::atomic<bool> shutdown{false};
+    // Процессор зарезервирован задачей на нескольких процессорах
+    std::atomic<bool> processor_reserved[4];
+    
+    // Задачи на нескольких процессорах
+    std::atomic<int> gang_tasks{0};
+    std::atomic<int> gang_aborts{0};
+    std::atomic<int> gang_waits{0};          // Неудачных попыток резервирования
+    std::atomic<double> gang_lost_ms{0.0};   // Процессор-мс прерванных задач
+    std::atomic<std::uint64_t> gang_wait_ticks{0};
+    
+    // Планирование при ожидании задачи на нескольких процессорах
+    SchedulingMode scheduling = SchedulingMode::Greedy;
+    boost::mutex backfill_mutex;                 // Захватывается до processor_mutex
+    bool head_active = false;                    // Ждет старшая задача head_task
+    Task head_task = Task();
+    std::uint64_t head_shadow = 0;               // Когда освободятся процессоры head, TscClock
+    unsigned head_processors = 0;                // Процессоры head (биты)
+    std::atomic<std::uint64_t> busy_until[4];    // Ожидаемое освобождение процессора, 0 - свободен
+    std::atomic<double> learned_runtime_ms[5];   // Изученная длительность по числу процессоров (1-4, см. gang_size)
+    
+    // Снимок исправных процессоров и эпохи для его освобождения
+    EpochDomain epochs;
+    std::atomic<ProcessorSnapshot*> healthy_processors;
+    std::atomic<int> healthy_count{4};  // Размер текущего снимка
     
     // Счетчик доступных процессоров
     std::atomic<int> available_processors;
     
     // Счетчик для генерации уникальных ID задач
     std::atomic<int> next_task_id;
+    
+    // Задержки выполненных задач
+    std::atomic<int> completed_tasks{0};
+    std::atomic<std::uint64_t> total_wait_ticks{0};  // Ожидание в очереди
+    std::atomic<std::uint64_t> total_run_ticks{0};   // Выполнение
+    std::atomic<std::uint64_t> max_wait_ticks{0};
+    std::atomic<double> busy_ms{0.0};                // Процессор-мс выполненных задач
+    
+    // Оценка ожидания новых задач и ее точность
+    WaitEstimator wait_estimator;
+    std::atomic<int> estimated_tasks{0};
+    std::atomic<double> estimate_error_ms{0.0};  // Сумма |факт - оценка|
+    
+    // Скомпилированные схемы, ожидающие задачи и процессор каждой схемы
+    boost::mutex circuits_mutex;
+    std::vector<std::shared_ptr<const CompiledCircuit>> circuits;
+    std::vector<std::shared_ptr<const std::vector<PauliString>>> observables;  // По номеру схемы
+    std::map<int, CircuitJob> circuit_jobs;                 // По номеру задачи
+    std::vector<int> circuit_home;                          // -1 - еще не выполнялась
+    std::atomic<int> circuit_tasks{0};
+    std::atomic<int> mps_tasks{0};
+    std::atomic<int> float_tasks{0};
+
+    // Больше state_vector_qubits кубитов вектор состояния рабочего потока
+    // не помещается в память (2^24 амплитуд - 256 МБ на поток)
+    static const int state_vector_qubits = 24;
+    // Схемы до small_circuit_qubits кубитов (до 1 МБ состояния) - малые задачи
+    static const int small_circuit_qubits = 16;
+    std::atomic<int> mps_bond{64};
+    
+    // Контрольные точки и потери при сбоях
+    std::atomic<int> checkpoint_interval{0};  // Ядер между точками, 0 - без точек
+    std::atomic<int> checkpoints{0};
+    std::atomic<int> migrations{0};           // Схем, прерванных сбоем процессора
+    std::atomic<double> checkpoint_ms{0.0};   // Снимки и восстановление
+    std::atomic<double> saved_ms{0.0};        // Вычисления, сохраненные точками
+    std::atomic<double> lost_ms{0.0};         // Вычисления после последней точки
+    
+    // Настраиваемые параметры рабочих потоков
+    static const int worker_count = 10;
+    static const int max_batch_size = 8;
+    std::atomic<int> batch_size{1};   // Задач за одно извлечение
+    static constexpr double batch_budget_ms = 50.0;  // Ожидаемой работы за одно извлечение
+    std::atomic<int> slots{4};        // Слотов семафора (меняет только автонастройка)
+    
+    // Автонастройка и ее последний замер
+    std::unique_ptr<Autotuner> autotuner;
+    std::uint64_t measured_at = TscClock::now();
+    int measured_done = 0;
+    std::uint64_t measured_wait = 0;
+};
+
+/*
+Замер освобождения по эпохам при постоянной замене общего объекта
+- readers потоков читают текущий список, один поток все время публикует
+  новый и откладывает старый
+- Для сравнения тот же цикл с чтением и заменой под мьютексом
+ */
+void run_epoch_benchmark(int readers, int milliseconds) {
+    struct Shared {
+        std::vector<int> items;
+    };
+
+    for (int variant = 0; variant < 2; ++variant) {
+        bool use_epochs = variant == 0;
+        EpochDomain domain;
+        boost::mutex mutex;
+        std::atomic<Shared*> current(new Shared{std::vector<int>(4, 1)});
+        std::atomic<bool> running(true);
+        std::atomic<std::uint64_t> reads(0);
+        std::atomic<std::uint64_t> publications(0);
+        std::atomic<std::uint64_t> max_pending(0);
+
+        boost::thread_group threads;
+        for (int reader = 0; reader < readers; ++reader) {
+            threads.create_thread([&] {
+                EpochParticipant participant(domain);
+                std::uint64_t count = 0;
+                long sum = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    if (use_epochs) {
+                        EpochGuard guard(participant);
+                        sum += current.load()->items[0];
+                    } else {
+                        boost::lock_guard<boost::mutex> lock(mutex);
+                        sum += current.load()->items[0];
+                    }
+                    if ((++count & 63) == 0 && use_epochs) participant.collect();
+                }
+                reads += count + (sum == 0);
+            });
+        }
+        threads.create_thread([&] {
+            EpochParticipant participant(domain);
+            while (running.load(std::memory_order_relaxed)) {
+                Shared* replacement = new Shared{std::vector<int>(4, 1)};
+                if (use_epochs) {
+                    participant.retire(current.exchange(replacement));
+                    if (participant.pending() > max_pending) max_pending = participant.pending();
+                } else {
+                    boost::lock_guard<boost::mutex> lock(mutex);
+                    delete current.exchange(replacement);
+                }
+                publications++;
+            }
+        });
+
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(milliseconds));
+        running = false;
+        threads.join_all();
+        delete current.load();
+
+        double seconds = milliseconds / 1000.0;
+        std::cout << (use_epochs ? "Эпохи" : "Мьютекс") << ": чтений " << reads / seconds / 1e6 << " млн/с"
+                  << ", замен " << publications / seconds / 1e6 << " млн/с";
+        if (use_epochs) {
+            std::cout << ", отложено " << domain.retired << ", удалено " << domain.freed
+                      << ", сдвигов эпохи " << domain.advances << ", макс. мусора у потока " << max_pending;
+        }
+        std::cout << "\n";
+    }
+}
+
+/*
+Нагрузка для сравнения автонастройки со статическими настройками
+- Поток-источник добавляет rate задач в секунду
+- 10 рабочих потоков берут задачи пачками, каждая задача ждет 1 мс
+  (обращение к процессору) и занимает слот семафора
+ */
+class TuningWorkload {
+public:
+    TuningWorkload(int batch, int spin, int slot_count, int rate) : batch(batch), rate(rate) {
+        TunableSpinIdle::spin_count().store(spin);
+        set_slots(slot_count);
+    }
+
+    void start() {
+        tasks.start(10, [this](int) { worker(); });
+        source = boost::thread([this] { produce(); });
+    }
+
+    void stop() {
+        running = false;
+        source.join();
+        tasks.stop();
+        set_slots(10);  // Возвращаем слоты, занятые при уменьшении
+    }
+
+    double measure() {
+        std::uint64_t now = TscClock::now();
+        std::uint64_t finished = done.load();
+        std::uint64_t wait = wait_ticks.load();
+        const TscClock& clock = TscClock::instance();
+        double seconds = clock.to_ms(now - measured_at) / 1000.0;
+        std::uint64_t count = finished - measured_done;
+        double mean_wait = count > 0 ? clock.to_ms(wait - measured_wait) / 1000.0 / count : 0.0;
+        measured_at = now;
+        measured_done = finished;
+        measured_wait = wait;
+        return seconds > 0 ? count / seconds / (1.0 + mean_wait) : 0.0;
+    }
+
+    void set_slots(int value) {
+        for (; slots < value; ++slots) tasks.release();
+        for (; slots > value; --slots) tasks.acquire();
+    }
+
+    std::atomic<int> batch;
+
+private:
+    struct Item {
+        std::uint64_t enqueued_at;
+        std::uint64_t queue_class() const { return 0; }
+    };
+
+    void produce() {
+        std::uint64_t interval = TscClock::instance().from_ms(1000.0 / rate);
+        std::uint64_t next = TscClock::now();
+        while (running) {
+            while (TscClock::now() < next) boost::this_thread::sleep_for(boost::chrono::microseconds(200));
+            tasks.push(Item{TscClock::now()});
+            next += interval;
+        }
+    }
+
+    void worker() {
+        std::vector<Item> items;
+        items.reserve(8);
+        while (tasks.pop_batch(items, batch.load())) {
+            for (const Item& item : items) {
+                tasks.acquire();
+                wait_ticks += TscClock::now() - item.enqueued_at;
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+                done++;
+                tasks.release();
+            }
+        }
+    }
+
+    Dispatcher<Item, PackedQueuePolicy<Item, 4>, TunableSpinIdle, 1> tasks;
+    int rate;
+    int slots = 1;
+    std::atomic<bool> running{true};
+    boost::thread source;
+    std::atomic<std::uint64_t> done{0};
+    std::atomic<std::uint64_t> wait_ticks{0};
+    std::uint64_t measured_at = TscClock::now();
+    std::uint64_t measured_done = 0;
+    std::uint64_t measured_wait = 0;
 };
 
-int main() {
+/*
+Перебор статических настроек, затем автонастройка с худшей из них
+ */
+void run_tuning_benchmark(int rate) {
+    const int batches[] = {1, 4, 8};
+    const int spins[] = {0, 128};
+    const int slot_counts[] = {1, 2, 4, 8};
+    double best = 0.0;
+    std::string best_name;
+    for (int batch : batches) {
+        for (int spin : spins) {
+            for (int slot_count : slot_counts) {
+                TuningWorkload workload(batch, spin, slot_count, rate);
+                workload.start();
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(300));
+                workload.measure();
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(700));
+                double score = workload.measure();
+                workload.stop();
+                std::string name = "batch " + std::to_string(batch) + ", spin " + std::to_string(spin) +
+                                   ", slots " + std::to_string(slot_count);
+                std::cout << "Статически " << name << ": оценка " << score << "\n";
+                if (score > best) {
+                    best = score;
+                    best_name = name;
+                }
+            }
+        }
+    }
+    std::cout << "Лучшая статическая настройка: " << best_name << ", оценка " << best << "\n";
+
+    TuningWorkload workload(8, 128, 1, rate);
+    Autotuner tuner(500, 0.03, [&workload] { return workload.measure(); });
+    int slot_count = 1;
+    tuner.add_knob("batch", 8, 1, 8, 1, [&workload](int value) { workload.batch.store(value); });
+    tuner.add_knob("spin", 128, 0, 256, 32, [](int value) { TunableSpinIdle::spin_count().store(value); });
+    tuner.add_knob("slots", 1, 1, 10, 1, [&workload, &slot_count](int value) {
+        workload.set_slots(value);
+        slot_count = value;
+    });
+    workload.start();
+    tuner.start();
+    boost::this_thread::sleep_for(boost::chrono::seconds(15));
+    tuner.stop();
+    workload.measure();
+    boost::this_thread::sleep_for(boost::chrono::seconds(1));
+    double tuned = workload.measure();
+    workload.stop();
+    std::cout << "Автонастройка: batch " << tuner.value(0) << ", spin " << tuner.value(1)
+              << ", slots " << slot_count << ", оценка " << tuned
+              << " (" << (best > 0 ? 100.0 * tuned / best : 0.0) << "% от лучшей статической)\n";
+}
+
+/*
+Вариационная схема: layers слоев RY, RZ с параметрами на каждом кубите
+и цепочка CX; параметров 2 * qubits * layers
+ */
+ParameterizedCircuit make_ansatz(int qubits, int layers) {
+    ParameterizedCircuit circuit(qubits);
+    for (int q = 0; q < qubits; ++q) circuit.h(q);
+    for (int layer = 0; layer < layers; ++layer) {
+        for (int q = 0; q < qubits; ++q) {
+            circuit.ry_param(q, 2 * (layer * qubits + q));
+            circuit.rz_param(q, 2 * (layer * qubits + q) + 1);
+        }
+        for (int q = 0; q + 1 < qubits; ++q) circuit.cx(q, q + 1);
+    }
+    return circuit;
+}
+
+/*
+Модель Изинга в поперечном поле на кольце из qubits кубитов:
+-sum Z_q Z_{q+1} - 0.5 sum X_q
+ */
+std::vector<PauliString> make_ising(int qubits) {
+    std::vector<PauliString> ising;
+    for (int q = 0; q < qubits; ++q) {
+        std::string zz(qubits, 'I');
+        std::string x(qubits, 'I');
+        zz[q] = zz[(q + 1) % qubits] = 'Z';
+        x[q] = 'X';
+        ising.push_back(PauliString::from_text(zz, -1.0));
+        ising.push_back(PauliString::from_text(x, -0.5));
+    }
+    return ising;
+}
+
+/*
+Время и точность MPS в зависимости от наибольшей связи
+- Схема make_ansatz(qubits, layers) со случайными углами, энергия Изинга
+- До 20 кубитов энергия сравнивается с вектором состояния
+ */
+void run_mps_benchmark(int qubits, int layers) {
+    ParameterizedCircuit ansatz = make_ansatz(qubits, layers);
+    CompiledCircuit compiled = ansatz.compile();
+    std::vector<PauliString> ising = make_ising(qubits);
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<> angle_dist(-3.14159, 3.14159);
+    std::vector<double> params(ansatz.parameters());
+    for (double& angle : params) angle = angle_dist(gen);
+    std::vector<StateVector::Matrix2> matrices;
+    const TscClock& clock = TscClock::instance();
+
+    bool exact = qubits <= 20;
+    double reference = 0.0;
+    std::cout << "MPS: " << qubits << " кубитов, слоев " << layers << ", вентилей " << compiled.gates() << "\n";
+    if (exact) {
+        StateVector state;
+        std::uint64_t begin = TscClock::now();
+        compiled.run(state, params.data(), matrices);
+        double ms = clock.to_ms(TscClock::now() - begin);
+        reference = pauli_energy(state, ising);
+        std::cout << "Вектор состояния: " << ms << " мс, память " << state.size() * sizeof(StateVector::Amplitude)
+                  << " Б, энергия " << reference << "\n";
+    }
+
+    const int bonds[] = {4, 8, 16, 32, 64};
+    for (int bond : bonds) {
+        MpsState mps(bond);
+        std::uint64_t begin = TscClock::now();
+        compiled.run(mps, params.data(), matrices);
+        double ms = clock.to_ms(TscClock::now() - begin);
+        double energy = pauli_energy(mps, ising);
+        std::cout << "Связь " << bond << ": " << ms << " мс, достигнута " << mps.bond_dimension()
+                  << ", память " << mps.memory_bytes() << " Б, отброшенный вес " << mps.discarded_weight()
+                  << ", энергия " << energy;
+        if (exact) std::cout << " (ошибка " << std::fabs(energy - reference) << ")";
+        std::cout << "\n";
+    }
+}
+
+/*
+Потеря загрузки процессоров из-за задач на нескольких процессорах
+- Одинаковая работа (32 процессор-задачи по 500-1500 мс): только
+  одиночные задачи против смеси, где percent работы - задачи на
+  processors процессорах
+- Сбои с вероятностью failure_percent на задачу, ремонт всех процессоров
+  раз в 500 мс; без сбоев загрузка сравнивается чисто, со сбоями
+  добавляются потери от снятия задач со всех процессоров
+- Загрузка: полезные процессор-мс / (4 процессора * время до последней задачи)
+ */
+void run_gang_benchmark(int processors, int percent, int failure_percent) {
+    const int units = 32;
+    for (int variant = 0; variant < 2; ++variant) {
+        int gangs = variant == 0 ? 0 : units * percent / 100 / processors;
+        int singles = units - gangs * processors;
+        std::vector<int> sizes(singles, 1);
+        sizes.insert(sizes.end(), gangs, processors);
+        std::mt19937 gen(1);
+        std::shuffle(sizes.begin(), sizes.end(), gen);
+        std::uniform_int_distribution<> priority_dist(1, 5);
+
+        std::cout << "\n=== Одиночных задач " << singles << ", на " << processors << " процессорах " << gangs << " ===\n";
+        QuantumSimulator simulator;
+        simulator.set_failure_probability(failure_percent / 100.0);
+        simulator.start();
+        std::uint64_t begin = TscClock::now();
+        for (int size : sizes) {
+            if (size == 1) simulator.add_task(priority_dist(gen), false);
+            else simulator.add_gang_task(priority_dist(gen), false, size);
+        }
+        // Сбои перенаправляют задачи как новые, поэтому выполненных может быть больше
+        while (simulator.tasks_done() < static_cast<int>(sizes.size())) {
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+            for (int j = 0; j < 4; ++j) simulator.processor_repair(j);
+        }
+        double elapsed_ms = TscClock::instance().to_ms(TscClock::now() - begin);
+        simulator.stop();
+        std::cout << "Время " << elapsed_ms / 1000.0 << " с, загрузка процессоров "
+                  << 100.0 * simulator.busy_processor_ms() / (4 * elapsed_ms) << "%\n";
+    }
+}
+
+/*
+Режимы планирования на одной нагрузке: начальная очередь одиночных задач
+младших приоритетов, затем каждые 500 мс задача на processors процессорах
+высшего приоритета и две одиночные; длительности 500-1500 мс
+В последнем варианте длительности объявлены при постановке, в остальных
+планировщик их изучает по выполненным задачам
+ */
+void run_backfill_benchmark(int processors, int waves) {
+    struct Variant {
+        const char* name;
+        SchedulingMode mode;
+        bool declared;
+    };
+    const Variant variants[] = {{"жадный", SchedulingMode::Greedy, false},
+                                {"строгий порядок", SchedulingMode::Strict, false},
+                                {"EASY, изученные оценки", SchedulingMode::Backfill, false},
+                                {"EASY, объявленные оценки", SchedulingMode::Backfill, true}};
+    for (const Variant& variant : variants) {
+        std::mt19937 gen(1);
+        std::uniform_int_distribution<> priority_dist(3, 5);
+        std::uniform_int_distribution<> runtime_dist(500, 1500);
+        auto runtime = [&]() { return variant.declared ? static_cast<double>(runtime_dist(gen)) : 0.0; };
+
+        std::cout << "\n=== " << variant.name << " ===\n";
+        QuantumSimulator simulator;
+        simulator.set_failure_probability(0.0);
+        simulator.set_scheduling(variant.mode);
+        simulator.start();
+        std::uint64_t begin = TscClock::now();
+        int submitted = 0;
+        for (int i = 0; i < 12; ++i, ++submitted) simulator.add_task(priority_dist(gen), false, -1, runtime());
+        for (int wave = 0; wave < waves; ++wave) {
+            simulator.add_gang_task(1, false, processors, -1, runtime());
+            simulator.add_task(priority_dist(gen), false, -1, runtime());
+            simulator.add_task(priority_dist(gen), false, -1, runtime());
+            submitted += 3;
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+        }
+        while (simulator.tasks_done() < submitted) {
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+        }
+        double elapsed_ms = TscClock::instance().to_ms(TscClock::now() - begin);
+        simulator.stop();
+        std::cout << "Итог (" << variant.name << "): время " << elapsed_ms / 1000.0 << " с, загрузка процессоров "
+                  << 100.0 * simulator.busy_processor_ms() / (4 * elapsed_ms) << "%, среднее ожидание "
+                  << simulator.mean_wait_ms() << " мс, на " << processors << " процессорах "
+                  << simulator.gang_wait_ms() << " мс\n";
+    }
+}
+
+/*
+Малые задачи на общих процессорах: 64 задачи, из них percent% малых
+(одна единица емкости, 400 мс), остальные занимают процессор (1200 мс);
+без учета емкости, процессор на одну задачу и емкостью capacity единиц
+ */
+void run_capacity_benchmark(int capacity, int percent) {
+    const int task_count = 64;
+    for (int units : {0, 1, capacity}) {
+        std::vector<bool> small(task_count, false);
+        for (int i = 0; i < task_count * percent / 100; ++i) small[i] = true;
+        std::mt19937 gen(1);
+        std::shuffle(small.begin(), small.end(), gen);
+        std::uniform_int_distribution<> priority_dist(1, 5);
+
+        std::cout << "\n=== Емкость процессора " << units << " ===\n";
+        QuantumSimulator simulator;
+        simulator.set_failure_probability(0.0);
+        simulator.set_processor_capacity(units);
+        simulator.start();
+        std::uint64_t begin = TscClock::now();
+        for (bool is_small : small) {
+            if (is_small) simulator.add_small_task(priority_dist(gen), false, 1, -1, 400.0);
+            else simulator.add_task(priority_dist(gen), false, -1, 1200.0);
+        }
+        while (simulator.tasks_done() < task_count) {
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+        }
+        double elapsed_ms = TscClock::instance().to_ms(TscClock::now() - begin);
+        simulator.stop();
+        std::cout << "Итог (емкость " << units << "): время " << elapsed_ms / 1000.0 << " с, "
+                  << task_count / (elapsed_ms / 1000.0) << " задач/с, загрузка процессоров "
+                  << 100.0 * simulator.busy_processor_ms() / (4 * elapsed_ms) << "%, среднее ожидание "
+                  << simulator.mean_wait_ms() << " мс\n";
+    }
+}
+
+/*
+Потери пропускной способности при плановом обслуживании: 48 задач
+500-1500 мс, у каждого процессора окно window_ms, окна по очереди через 2 с
+Варианты: без обслуживания, жесткая остановка, освобождение заранее по
+объявленным и по изученным длительностям
+ */
+void run_maintenance_benchmark(int window_ms) {
+    struct Variant {
+        const char* name;
+        bool windows;
+        bool drain;
+        bool declared;
+    };
+    const Variant variants[] = {{"без обслуживания", false, false, true},
+                                {"жесткая остановка", true, false, true},
+                                {"освобождение, объявленные оценки", true, true, true},
+                                {"освобождение, изученные оценки", true, true, false}};
+    const int task_count = 48;
+    double baseline = 0.0;
+    for (const Variant& variant : variants) {
+        std::mt19937 gen(1);
+        std::uniform_int_distribution<> priority_dist(1, 5);
+        std::uniform_int_distribution<> runtime_dist(500, 1500);
+
+        std::cout << "\n=== " << variant.name << " ===\n";
+        QuantumSimulator simulator;
+        simulator.set_failure_probability(0.0);
+        if (variant.windows) {
+            for (int p = 0; p < 4; ++p) simulator.schedule_maintenance(p, 1500.0 + 2000.0 * p, window_ms, variant.drain);
+        }
+        simulator.start();
+        std::uint64_t begin = TscClock::now();
+        for (int i = 0; i < task_count; ++i) {
+            double runtime = runtime_dist(gen);
+            simulator.add_task(priority_dist(gen), false, -1, variant.declared ? runtime : 0.0);
+        }
+        while (simulator.tasks_done() < task_count) {
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+        }
+        double elapsed_ms = TscClock::instance().to_ms(TscClock::now() - begin);
+        simulator.stop();
+        double throughput = task_count / (elapsed_ms / 1000.0);
+        if (!variant.windows) baseline = throughput;
+        std::cout << "Итог (" << variant.name << "): время " << elapsed_ms / 1000.0 << " с, " << throughput
+                  << " задач/с (потеря " << 100.0 * (1.0 - throughput / baseline) << "%), потеряно работы "
+                  << simulator.maintenance_lost_processor_ms() << " процессор-мс\n";
+    }
+}
+
+/*
+Время выполнения схемы на векторе состояния state (в мс), лучшее из repeats
+ */
+template <typename State>
+double time_circuit(const CompiledCircuit& compiled, const std::vector<double>& params, State& state, int repeats) {
+    std::vector<StateVector::Matrix2> matrices;
+    double best = 0.0;
+    for (int repeat = 0; repeat < repeats; ++repeat) {
+        std::uint64_t begin = TscClock::now();
+        compiled.run(state, params.data(), matrices);
+        double ms = TscClock::instance().to_ms(TscClock::now() - begin);
+        if (repeat == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+/*
+Вектор состояния двойной и одинарной точности: вентилей в секунду,
+память и расхождение результатов (амплитуды, верность, энергия Изинга)
+ */
+void run_precision_benchmark(int qubits, int layers) {
+    ParameterizedCircuit ansatz = make_ansatz(qubits, layers);
+    CompiledCircuit compiled = ansatz.compile();
+    std::vector<PauliString> ising = make_ising(qubits);
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<> angle_dist(-3.14159, 3.14159);
+    std::vector<double> params(ansatz.parameters());
+    for (double& angle : params) angle = angle_dist(gen);
+
+    StateVector exact;
+    StateVectorFloat single;
+    double double_ms = time_circuit(compiled, params, exact, 3);
+    double single_ms = time_circuit(compiled, params, single, 3);
+
+    double max_error = 0.0;
+    double norm = 0.0;
+    std::complex<double> overlap(0.0, 0.0);
+    for (std::size_t i = 0; i < exact.size(); ++i) {
+        std::complex<double> approximate(single[i]);
+        max_error = std::max(max_error, std::abs(exact[i] - approximate));
+        overlap += std::conj(exact[i]) * approximate;
+        norm += std::norm(approximate);
+    }
+    double exact_energy = pauli_energy(exact, ising);
+    double single_energy = pauli_energy(single, ising);
+
+    std::cout << "Точность: " << qubits << " кубитов, вентилей " << compiled.gates()
+              << ", ядер " << compiled.kernels() << "\n"
+              << "double: " << double_ms << " мс, " << compiled.gates() / double_ms * 1000.0 << " вентилей/с, память "
+              << exact.size() * sizeof(StateVector::Amplitude) / 1048576.0 << " МБ\n"
+              << "float: " << single_ms << " мс, " << compiled.gates() / single_ms * 1000.0 << " вентилей/с, память "
+              << single.size() * sizeof(StateVectorFloat::Amplitude) / 1048576.0 << " МБ"
+              << " (ускорение " << double_ms / single_ms << ")\n"
+              << "Расхождение float: амплитуды до " << max_error << ", 1 - верность " << 1.0 - std::norm(overlap) / norm
+              << ", ошибка нормы " << std::fabs(norm - 1.0)
+              << ", энергия " << single_energy << " против " << exact_energy
+              << " (ошибка " << std::fabs(single_energy - exact_energy) << ")\n";
+}
+
+/*
+Потери вычислений при сбоях процессоров без контрольных точек и с ними
+- task_count длинных схем qubits кубитов, каждые 700 мс отказывает
+  случайный процессор и через 300 мс восстанавливается
+- Итоги по каждому варианту печатает stop()
+ */
+void run_checkpoint_benchmark(int qubits, int interval) {
+    const int task_count = 8;
+    const int intervals[] = {0, interval};
+    for (int kernels : intervals) {
+        std::cout << "\n=== Контрольные точки: " << (kernels > 0 ? std::to_string(kernels) + " ядер" : "нет") << " ===\n";
+        QuantumSimulator simulator;
+        simulator.set_checkpoint_interval(kernels);
+        int circuit = simulator.register_circuit(make_ansatz(qubits, 40));
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<> angle_dist(-3.14159, 3.14159);
+        simulator.start();
+        std::uint64_t begin = TscClock::now();
+        for (int i = 0; i < task_count; ++i) {
+            std::vector<double> params(2 * qubits * 40);
+            for (double& angle : params) angle = angle_dist(gen);
+            simulator.add_circuit_task(3, false, circuit, params);
+        }
+
+        while (simulator.circuit_tasks_done() < task_count) {
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(700));
+            int processor = gen() % 4;
+            simulator.processor_failure(processor);
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(300));
+            simulator.processor_repair(processor);
+        }
+        double seconds = TscClock::instance().to_ms(TscClock::now() - begin) / 1000.0;
+        simulator.stop();
+        std::cout << "Все схемы за " << seconds << " с\n";
+    }
+}
+
+/*
+Накладные расходы на задачу: компиляция схемы для каждой задачи
+против одной компиляции и привязки параметров
+ */
+void run_circuit_benchmark(int qubits, int task_count) {
+    ParameterizedCircuit ansatz = make_ansatz(qubits, 4);
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<> angle_dist(-3.14159, 3.14159);
+    std::vector<std::vector<double>> params(task_count, std::vector<double>(ansatz.parameters()));
+    for (std::vector<double>& set : params) {
+        for (double& angle : set) angle = angle_dist(gen);
+    }
+
+    const TscClock& clock = TscClock::instance();
+    StateVector state;
+    std::vector<StateVector::Matrix2> matrices;
+    double checksum = 0.0;
+
+    // Компиляция на каждую задачу
+    std::uint64_t compile_ticks = 0;
+    std::uint64_t begin = TscClock::now();
+    for (const std::vector<double>& set : params) {
+        std::uint64_t compile_begin = TscClock::now();
+        CompiledCircuit compiled = ansatz.compile();
+        compile_ticks += TscClock::now() - compile_begin;
+        compiled.run(state, set.data(), matrices);
+        checksum += state.expectation_z(0);
+    }
+    double each_us = clock.to_us(TscClock::now() - begin) / task_count;
+
+    // Одна компиляция, привязка параметров на задачу
+    std::uint64_t bind_ticks = 0;
+    begin = TscClock::now();
+    CompiledCircuit compiled = ansatz.compile();
+    for (const std::vector<double>& set : params) {
+        state.reset(qubits);
+        std::uint64_t bind_begin = TscClock::now();
+        compiled.bind(set.data(), matrices);
+        bind_ticks += TscClock::now() - bind_begin;
+        compiled.execute(state, matrices);
+        checksum -= state.expectation_z(0);
+    }
+    double once_us = clock.to_us(TscClock::now() - begin) / task_count;
+
+    std::cout << "Схема: " << qubits << " кубитов, вентилей " << compiled.gates()
+              << ", ядер после слияния " << compiled.kernels() << ", задач " << task_count << "\n"
+              << "Компиляция на задачу: " << each_us << " мкс на задачу, из них компиляция "
+              << clock.to_us(compile_ticks) / task_count << " мкс\n"
+              << "Одна компиляция: " << once_us << " мкс на задачу, из них привязка "
+              << clock.to_us(bind_ticks) / task_count << " мкс"
+              << " (расхождение результатов " << checksum << ")\n";
+}
+
+/*
+Средние значения terms строк Паули на состоянии qubits кубитов
+Строки берутся из 16 масок переворота (как у гамильтонианов с общими
+парами возбуждений) со случайными знаковыми частями
+ */
+void run_pauli_benchmark(int qubits, int term_count, int threads) {
+    std::mt19937_64 gen(1);
+    std::uniform_real_distribution<> angle_dist(-3.14159, 3.14159);
+    ParameterizedCircuit ansatz = make_ansatz(qubits, 2);
+    std::vector<double> params(ansatz.parameters());
+    for (double& angle : params) angle = angle_dist(gen);
+    StateVector state;
+    std::vector<StateVector::Matrix2> matrices;
+    ansatz.compile().run(state, params.data(), matrices);
+
+    std::uint64_t all = qubits >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << qubits) - 1;
+    std::vector<std::uint64_t> flips(16);
+    flips[0] = 0;
+    for (std::size_t i = 1; i < flips.size(); ++i) flips[i] = gen() & all;
+    std::vector<PauliString> terms;
+    for (int k = 0; k < term_count; ++k) {
+        std::uint64_t x = flips[k % flips.size()];
+        std::uint64_t z = gen() & all;
+        terms.push_back(PauliString{x, z, 1.0 / term_count});
+    }
+
+    const TscClock& clock = TscClock::instance();
+    std::vector<double> values;
+    std::uint64_t begin = TscClock::now();
+    pauli_expectations(state, terms, values, threads);
+    double batched = clock.to_ms(TscClock::now() - begin) / 1000.0;
+
+    // Для сравнения - по одной строке за проход (на первых 16 строках)
+    int sample = std::min(term_count, 16);
+    std::vector<double> single;
+    double drift = 0.0;
+    begin = TscClock::now();
+    for (int k = 0; k < sample; ++k) {
+        pauli_expectations(state, std::vector<PauliString>(1, terms[k]), single, threads);
+        drift = std::max(drift, std::fabs(single[0] - values[k]));
+    }
+    double each = clock.to_ms(TscClock::now() - begin) / 1000.0 / sample;
+
+    std::cout << "Строки Паули: " << qubits << " кубитов, строк " << term_count << ", потоков " << threads << "\n"
+              << "Пакетно: " << batched << " с, " << term_count / batched << " строк/с\n"
+              << "По одной: " << 1.0 / each << " строк/с (расхождение " << drift << ")\n";
+}
+
+/*
+Задача с меткой времени для сравнения куч (по размеру как Task)
+Вершина std::priority_queue - наименьший срок
+ */
+struct HeapBenchTask {
+    std::uint64_t deadline;
+    int priority;
+    bool is_critical;
+    int task_id;
+    std::uint64_t enqueued_at;
+    double estimated_ms;
+    int circuit_id;
+    int processors;
+    double runtime_ms;
+    int units;
+
+    bool operator<(const HeapBenchTask& other) const { return deadline > other.deadline; }
+};
+
+/*
+Заполнение и опустошение очереди count задачами со случайными сроками,
+rounds раз; нс на push и на pop, нарушения порядка извлечения
+ */
+template <typename Queue, typename Push, typename Pop>
+void time_heap(const char* name, Queue& queue, const std::vector<HeapBenchTask>& items, int rounds,
+               Push push, Pop pop) {
+    const TscClock& clock = TscClock::instance();
+    std::uint64_t push_ticks = 0, pop_ticks = 0, disorder = 0;
+    for (int round = 0; round < rounds; ++round) {
+        std::uint64_t begin = TscClock::now();
+        for (const HeapBenchTask& item : items) push(queue, item);
+        std::uint64_t filled = TscClock::now();
+        std::uint64_t last = 0;
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            std::uint64_t deadline = pop(queue);
+            if (deadline < last) disorder++;
+            last = deadline;
+        }
+        pop_ticks += TscClock::now() - filled;
+        push_ticks += filled - begin;
+    }
+    double operations = static_cast<double>(items.size()) * rounds;
+    std::cout << "  " << name << ": push " << clock.to_ns(push_ticks) / operations
+              << " нс, pop " << clock.to_ns(pop_ticks) / operations << " нс"
+              << (disorder > 0 ? ", нарушений порядка " + std::to_string(disorder) : std::string()) << "\n";
+}
+
+/*
+DaryHeap (4 и 8) против std::priority_queue<задача> на 1 тыс., 1 млн
+и 100 млн элементов (не больше max_entries)
+Память заранее зарезервирована; малые размеры повторяются, чтобы каждый
+замер покрывал ~10 млн операций
+ */
+void run_heap_benchmark(std::size_t max_entries) {
+    const std::size_t sizes[] = {1000, 1000000, 100000000};
+    std::mt19937_64 gen(1);
+    for (std::size_t count : sizes) {
+        if (count > max_entries) break;
+        std::vector<HeapBenchTask> items(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            items[i] = HeapBenchTask{gen() >> 1, static_cast<int>(i % 5) + 1, i % 10 == 0, static_cast<int>(i),
+                                     0, -1.0, -1, 1, 0.0, 0};
+        }
+        int rounds = static_cast<int>(std::max<std::size_t>(1, 10000000 / count));
+        std::cout << "Куча: " << count << " элементов, повторов " << rounds << "\n";
+        {
+            std::vector<HeapBenchTask> storage;
+            storage.reserve(count);
+            std::priority_queue<HeapBenchTask> queue(std::less<HeapBenchTask>(), std::move(storage));
+            time_heap("std::priority_queue", queue, items, rounds,
+                      [](std::priority_queue<HeapBenchTask>& q, const HeapBenchTask& item) { q.push(item); },
+                      [](std::priority_queue<HeapBenchTask>& q) {
+                          std::uint64_t deadline = q.top().deadline;
+                          q.pop();
+                          return deadline;
+                      });
+        }
+        {
+            DaryHeap<HeapBenchTask, 4> heap;
+            heap.reserve(count);
+            time_heap("DaryHeap<4>", heap, items, rounds,
+                      [](DaryHeap<HeapBenchTask, 4>& h, const HeapBenchTask& item) { h.push(item.deadline, item); },
+                      [](DaryHeap<HeapBenchTask, 4>& h) { return h.pop().deadline; });
+        }
+        {
+            DaryHeap<HeapBenchTask, 8> heap;
+            heap.reserve(count);
+            time_heap("DaryHeap<8>", heap, items, rounds,
+                      [](DaryHeap<HeapBenchTask, 8>& h, const HeapBenchTask& item) { h.push(item.deadline, item); },
+                      [](DaryHeap<HeapBenchTask, 8>& h) { return h.pop().deadline; });
+        }
+    }
+}
+
+/*
+Стоимость одной метки времени: calls вызовов подряд, время цикла по
+std::chrono::steady_clock; sink не дает компилятору выбросить вызовы
+ */
+template <typename Now>
+double ns_per_timestamp(Now now, int calls, std::uint64_t& sink) {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) sink += now();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / calls;
+}
+
+/*
+Метки TscClock против boost::chrono и std::chrono, нс на вызов
+ */
+void run_clock_benchmark(int calls) {
+    const TscClock& clock = TscClock::instance();
+    std::uint64_t sink = 0;
+    std::cout << "Метки времени: " << calls << " вызовов, TscClock "
+              << (clock.uses_tsc() ? "на rdtsc" : "на steady_clock (нет инвариантного TSC)") << "\n";
+    std::cout << "TscClock::now: "
+              << ns_per_timestamp([] { return TscClock::now(); }, calls, sink) << " нс\n";
+    std::cout << "boost::chrono::steady_clock: "
+              << ns_per_timestamp([] {
+                     return static_cast<std::uint64_t>(boost::chrono::steady_clock::now().time_since_epoch().count());
+                 }, calls, sink) << " нс\n";
+    std::cout << "boost::chrono::high_resolution_clock: "
+              << ns_per_timestamp([] {
+                     return static_cast<std::uint64_t>(boost::chrono::high_resolution_clock::now().time_since_epoch().count());
+                 }, calls, sink) << " нс\n";
+    std::cout << "std::chrono::steady_clock: "
+              << ns_per_timestamp([] {
+                     return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+                 }, calls, sink) << " нс\n";
+    std::cout << "std::chrono::system_clock: "
+              << ns_per_timestamp([] {
+                     return static_cast<std::uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+                 }, calls, sink) << " нс\n";
+    std::cout << "(контрольная сумма " << (sink & 0xff) << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    // Кучи по срокам: 1 heap [наибольший размер] (100 млн - ~15 ГБ памяти)
+    if (argc > 1 && std::string(argv[1]) == "heap") {
+        run_heap_benchmark(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+
+    // Стоимость метки времени: 1 clock [вызовов]
+    if (argc > 1 && std::string(argv[1]) == "clock") {
+        run_clock_benchmark(argc > 2 ? std::atoi(argv[2]) : 10000000);
+        return 0;
+    }
+
+    // Плановое обслуживание процессоров: 1 maintenance [длительность окна, мс]
+    if (argc > 1 && std::string(argv[1]) == "maintenance") {
+        run_maintenance_benchmark(argc > 2 ? std::atoi(argv[2]) : 1500);
+        return 0;
+    }
+
+    // Несколько малых задач на одном процессоре: 1 capacity [единиц] [процент малых]
+    if (argc > 1 && std::string(argv[1]) == "capacity") {
+        run_capacity_benchmark(argc > 2 ? std::atoi(argv[2]) : 4, argc > 3 ? std::atoi(argv[3]) : 75);
+        return 0;
+    }
+
+    // Режимы планирования при задачах на нескольких процессорах:
+    // 1 backfill [процессоров] [волн]
+    if (argc > 1 && std::string(argv[1]) == "backfill") {
+        run_backfill_benchmark(argc > 2 ? std::atoi(argv[2]) : 4, argc > 3 ? std::atoi(argv[3]) : 12);
+        return 0;
+    }
+
+    // Загрузка при задачах на нескольких процессорах:
+    // 1 gang [процессоров] [процент работы] [процент сбоев]
+    if (argc > 1 && std::string(argv[1]) == "gang") {
+        run_gang_benchmark(argc > 2 ? std::atoi(argv[2]) : 2, argc > 3 ? std::atoi(argv[3]) : 50,
+                           argc > 4 ? std::atoi(argv[4]) : 0);
+        return 0;
+    }
+
+    // Двойная и одинарная точность: 1 precision [кубитов] [слоев]
+    if (argc > 1 && std::string(argv[1]) == "precision") {
+        run_precision_benchmark(argc > 2 ? std::atoi(argv[2]) : 22, argc > 3 ? std::atoi(argv[3]) : 4);
+        return 0;
+    }
+
+    // Потери при сбоях с контрольными точками: 1 checkpoint [кубитов] [ядер между точками]
+    if (argc > 1 && std::string(argv[1]) == "checkpoint") {
+        run_checkpoint_benchmark(argc > 2 ? std::atoi(argv[2]) : 18, argc > 3 ? std::atoi(argv[3]) : 100);
+        return 0;
+    }
+
+    // Время и точность MPS по наибольшей связи: 1 mps [кубитов] [слоев]
+    if (argc > 1 && std::string(argv[1]) == "mps") {
+        run_mps_benchmark(argc > 2 ? std::atoi(argv[2]) : 20, argc > 3 ? std::atoi(argv[3]) : 4);
+        return 0;
+    }
+
+    // Средние значения строк Паули: 1 pauli [кубитов] [строк] [потоков]
+    if (argc > 1 && std::string(argv[1]) == "pauli") {
+        run_pauli_benchmark(argc > 2 ? std::atoi(argv[2]) : 24, argc > 3 ? std::atoi(argv[3]) : 10000,
+                            argc > 4 ? std::atoi(argv[4]) : static_cast<int>(boost::thread::hardware_concurrency()));
+        return 0;
+    }
+
+    // Накладные расходы параметризованных схем: 1 circuits [кубитов] [задач]
+    if (argc > 1 && std::string(argv[1]) == "circuits") {
+        run_circuit_benchmark(argc > 2 ? std::atoi(argv[2]) : 10, argc > 3 ? std::atoi(argv[3]) : 2000);
+        return 0;
+    }
+
+    // Сравнение автонастройки со статическими настройками: 1 tune [задач в секунду]
+    if (argc > 1 && std::string(argv[1]) == "tune") {
+        run_tuning_benchmark(argc > 2 ? std::atoi(argv[2]) : 2000);
+        return 0;
+    }
+
+    // Замер освобождения по эпохам: 1 epochs [читателей]
+    if (argc > 1 && std::string(argv[1]) == "epochs") {
+        run_epoch_benchmark(argc > 2 ? std::atoi(argv[2]) : 4, 1000);
+        return 0;
+    }
+
     std::srand(std::time(0));  // Инициализация генератора случайных чисел
     
+    // Трассировка временной шкалы: TRACE_FILE=trace.json
+    if (const char* trace_file = std::getenv("TRACE_FILE")) {
+        Tracer::instance().start(trace_file);
+    }
+    
     QuantumSimulator simulator;
+    simulator.set_checkpoint_interval(32);
+    // 1 autotune - автонастройка рабочих потоков во время работы
+    if (argc > 1 && std::string(argv[1]) == "autotune") {
+        simulator.enable_autotune(2000);
+    }
     std::cout << "Запуск программы" << std::endl;
     simulator.start();
 
@@ -294,9 +2290,38 @@ int main() {
         int priority = priority_dist(gen);
         bool is_critical = critical_dist(gen);
         simulator.add_task(priority, is_critical, i + 1);
+        if (i % 10 == 9) {
+            WaitEstimate estimate = simulator.estimate_wait(3, false);
+            std::cout << "Оценка ожидания задачи приоритета 3: " << estimate.expected_ms
+                      << " мс (до " << estimate.pessimistic_ms << " мс), впереди " << estimate.ahead << "\n";
+        }
         boost::this_thread::sleep_for(boost::chrono::milliseconds(200));
     }
 
+    // Задачи, которым нужны 2 процессора одновременно
+    for (int i = 0; i < 3; ++i) {
+        simulator.add_gang_task(priority_dist(gen), false, 2);
+    }
+
+    // Вариационная серия: одна схема, 20 наборов углов, энергия модели Изинга
+    int ansatz = simulator.register_circuit(make_ansatz(8, 3), make_ising(8));
+    std::uniform_real_distribution<> angle_dist(-3.14159, 3.14159);
+    for (int i = 0; i < 20; ++i) {
+        std::vector<double> params(2 * 8 * 3);
+        for (double& angle : params) angle = angle_dist(gen);
+        // Каждая четвертая - в одинарной точности
+        simulator.add_circuit_task(priority_dist(gen), false, ansatz, params,
+                                   i % 4 == 3 ? SimulationBackend::StateVectorFloat : SimulationBackend::Auto);
+    }
+
+    // Цепочка из 64 кубитов с малой запутанностью - автоматически на MPS
+    int chain = simulator.register_circuit(make_ansatz(64, 2), make_ising(64));
+    for (int i = 0; i < 2; ++i) {
+        std::vector<double> params(2 * 64 * 2);
+        for (double& angle : params) angle = angle_dist(gen);
+        simulator.add_circuit_task(priority_dist(gen), false, chain, params);
+    }
+
     // Периодически восстанавливаем все процессоры
     for (int i = 0; i < 2; ++i) {
         boost::this_thread::sleep_for(boost::chrono::seconds(4));
@@ -311,6 +2336,7 @@ int main() {
     
     std::cout << "\n Остановка" << std::endl;
     simulator.stop();
+    Tracer::instance().stop();
     
     std::cout << "Работа завершена." << std::endl;
     return 0;
@@ -1,12 +1,33 @@
 
 #include <iostream>
-#include <queue>
 #include <vector>
 #include <random>
 #include <atomic>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
 #include <boost/thread.hpp>
-#include <boost/interprocess/sync/interprocess_semaphore.hpp>
 #include <boost/chrono.hpp>
+#include "dispatcher.hpp"
+#include "dary_heap.hpp"
+#include "grid_des.hpp"
+#include "trace.hpp"
+#include "tsc_clock.hpp"
+#include "station_windows.hpp"
+#include "alignment_buffer.hpp"
+#include "harmonics.hpp"
+#include "latency_histogram.hpp"
+#include "forecaster.hpp"
+#include "realtime.hpp"
+
+/*
+Правило масштабирования обработчиков
+- Reactive - по текущей нагрузке (больше 80% - добавить, меньше 50% - убрать)
+- Predictive - по прогнозу поступлений на 2 с вперед, до всплеска
+ */
+enum class ScalingMode { Reactive, Predictive };
 
 class EnergyMonitorSystem {
 public:
@@ -15,39 +36,91 @@ public:
     - Начальная нагрузка (0%)
     - Максимальная нагрузка (100%)
     - Базовые обработчики (2 шт)
-    - Семафор для контроля обработчиков
+    - Диспетчер пакетов с семафором для контроля обработчиков (2 шт)
+    - Максимальный возраст пакета по приоритетам (2-10 с)
+    - Окна по 1 с на станцию с допустимым опозданием 2 с
+    - Выравнивание показаний всех станций по кадрам 1 с с таймаутом 3 с
+    - Пул блоков отсчетов (64 отсчета на период 50 Гц) и гармонический анализ
+      пачками по 16 блоков, гармоники 1-15
      */
     EnergyMonitorSystem() : 
         current_load(0),
         max_load(100),
         base_handlers(2),
         additional_handlers(0),
-        data_semaphore(2) // Инициализация семафора с 2 обработчиками
+        start_ticks(TscClock::now()),
+        windows(station_count, 1000, 2000, 8,
+                [](const WindowSummary& window) {
+                    Tracer::instance().instant("window", "windows", "station", window.station,
+                                               "packets", window.packets);
+                }),
+        frames(station_count, 1000, 3000, 8,
+               [this](const AlignedFrame& frame) { analyze_frame(frame); }),
+        sample_pool(1024, 64),
+        harmonics(64, 1, 16, 15,
+                  [this](const HarmonicResult& result) { record_harmonics(result); }),
+        forecaster(0.5, 0.3)
     {
         srand(time(0));
+
+        // Чем ниже приоритет, тем дольше показания остаются полезными
+        const int default_max_age_ms[6] = {0, 2000, 3000, 5000, 8000, 10000};
+        for (int priority = 1; priority <= 5; ++priority) {
+            set_max_age(priority, default_max_age_ms[priority]);
+        }
+    }
+
+    /*
+    Максимальный возраст пакета приоритета priority (1-5), мс
+    Более старые пакеты отбрасываются при извлечении из очереди
+    0 - без ограничения; задается до start()
+     */
+    void set_max_age(int priority, int max_age_ms) {
+        max_age_ticks[priority] = max_age_ms > 0 ? TscClock::instance().from_ms(max_age_ms) : 0;
     }
 
     /*
     priority Приоритет данных (1 - наивысший)
     is_critical Флаг критически важных данных
+    sequence Порядковый номер пакета станции
+    event_time_ms Время измерения по часам станции, мс от запуска системы
+    voltage Измеренное напряжение, В
+    samples Блок отсчетов в sample_pool (-1 - без отсчетов)
      */
-    void add_data_packet(int priority, bool is_critical, int station_id) {
-        boost::unique_lock<boost::mutex> lock(data_mutex);
-        data_packets.push(DataPacket{priority, is_critical, station_id});
-        lock.unlock();
-        data_condition.notify_one(); // Уведомляем сервер о новых данных
+    void add_data_packet(int priority, bool is_critical, int station_id,
+                         std::uint32_t sequence, std::int64_t event_time_ms, double voltage,
+                         int samples = -1) {
+        // Диспетчер уведомляет сервер о новых данных
+        arrivals++;
+        DataPacket packet{priority, is_critical, station_id, TscClock::now(),
+                          sequence, event_time_ms, voltage, samples};
+        // В режиме реального времени критические пакеты идут мимо сервера,
+        // при переполнении кольца - обычным путем
+        if (realtime_handlers > 0 && is_critical && critical_packets.try_push(packet)) return;
+        data_packets.push(packet);
     }
 
     /*
     Запуск системы мониторинга
     Создаем
-    - 1 поток для серверного обработчика
+    - 5 потоков обработчиков (2 базовых + 3 дополнительных), работают столько, сколько слотов в семафоре
     - 10 потоков для станций мониторинга
      */
     void start() {
-        server_thread = boost::thread(&EnergyMonitorSystem::server_handler, this);
+        handlers_changed_at = TscClock::now();
+        forecast_sampled_at = handlers_changed_at;
+        // Потоков обработчиков - на наибольшее их число, одновременно
+        // работают столько, сколько слотов в семафоре
+        data_packets.start(base_handlers + max_additional_handlers, [this](int) { server_handler(); });
+        if (realtime_handlers > 0) {
+            memory_locked = lock_process_memory();
+            if (!memory_locked) {
+                std::cout << "mlockall не разрешен, память не закреплена\n";
+            }
+            critical_packets.start(realtime_handlers, [this](int) { critical_handler(); });
+        }
         
-        for (int i = 0; i < 10; ++i) {
+        for (int i = 0; i < station_count; ++i) {
             station_threads.create_thread(boost::bind(&EnergyMonitorSystem::station_thread, this, i));
         }
     }
@@ -56,13 +129,106 @@ public:
   //Остановка системы мониторинга
 
     void stop() {
-        {
-            boost::unique_lock<boost::mutex> lock(data_mutex);
-            shutdown = true;
+        data_packets.stop();         // Флаг завершения, ожидание обработчиков
+        critical_packets.stop();     // Обработчики критических пакетов
+        if (memory_locked) {
+            unlock_process_memory();  // Закрепление действует на весь процесс
+            memory_locked = false;
         }
-        data_condition.notify_all(); // Будим все ожидающие потоки
         station_threads.join_all();  // Ожидаем завершения станций
-        server_thread.join();        // Ожидаем завершения сервера
+        harmonics.flush();           // Неполная пачка блоков отсчетов
+        account_handler_time();
+
+        // Итоги по задержкам обработанных пакетов
+        const TscClock& clock = TscClock::instance();
+        std::cout << "Масштабирование " << (scaling_mode == ScalingMode::Predictive ? "по прогнозу" : "по нагрузке")
+                  << ": p99 ожидания " << wait_histogram.percentile(0.99) / 1000.0 << " мс"
+                  << ", обработчико-секунд " << handler_seconds
+                  << " (занято " << busy_handler_seconds() << ")\n";
+        std::cout << "Критические пакеты (" << (realtime_handlers > 0 ? "реальное время" : "через сервер")
+                  << "): " << critical_latency.count()
+                  << ", задержка до обработчика p99 " << critical_latency.percentile(0.99)
+                  << " мкс, p99.99 " << critical_latency.percentile(0.9999)
+                  << " мкс, максимум " << critical_latency.max() << " мкс";
+        if (realtime_handlers > 0) {
+            std::cout << ", SCHED_FIFO " << (realtime_fifo ? "да" : "нет")
+                      << ", срабатываний защиты " << protection_trips;
+        }
+        std::cout << "\n";
+        if (processed_packets > 0) {
+            std::cout << "Обработано пакетов: " << processed_packets
+                      << ", среднее ожидание в очереди: " << clock.to_ms(total_wait_ticks) / processed_packets << " мс"
+                      << ", максимум: " << clock.to_ms(max_wait_ticks) << " мс"
+                      << ", средняя обработка: " << clock.to_ms(total_handle_ticks) / processed_packets << " мс\n";
+        }
+
+        std::cout << "Окон закрыто: " << windows.finalized
+                  << ", пакетов не по порядку: " << windows.reordered
+                  << ", опоздавших: " << windows.late
+                  << ", пропусков: " << windows.missing
+                  << ", закрыто принудительно: " << windows.forced << "\n";
+        std::cout << "Кадров выравнивания: полных " << frames.complete_frames
+                  << ", по таймауту " << frames.partial_frames
+                  << " (досрочно " << frames.evicted << ")"
+                  << ", опоздавших показаний " << frames.late
+                  << ", макс. разброс напряжения " << max_voltage_spread << " В\n";
+        if (harmonics.blocks > 0) {
+            double busy_seconds = clock.to_ms(harmonics.busy_ticks) / 1000.0;
+            std::cout << "Гармонический анализ: блоков " << harmonics.blocks
+                      << ", средний КНИ " << 100.0 * thd_sum / harmonics.blocks << "%"
+                      << ", максимальный " << 100.0 * max_thd << "%"
+                      << ", " << (busy_seconds > 0 ? harmonics.blocks / busy_seconds : 0.0)
+                      << " блоков/с на ядро\n";
+        }
+
+        std::uint64_t expired_total = expired();
+        if (expired_total > 0) {
+            std::cout << "Устаревших пакетов отброшено: " << expired_total << " (по приоритетам 1-5:";
+            for (int priority = 1; priority <= 5; ++priority) std::cout << " " << expired_packets[priority];
+            std::cout << "), оценка сэкономленного времени обработчиков ~"
+                      << clock.to_ms(total_handle_ticks) / std::max<std::uint64_t>(processed_packets, 1) * expired_total
+                      << " мс\n";
+        }
+    }
+
+    /*
+    Выбор правила масштабирования обработчиков (до start())
+     */
+    void set_scaling_mode(ScalingMode mode) {
+        scaling_mode = mode;
+    }
+
+    /*
+    Множитель частоты отправки станций (1 - в среднем пакет в секунду
+    на станцию); можно менять во время работы
+     */
+    void set_send_rate(double rate) {
+        send_rate.store(rate);
+    }
+
+    // Итоги масштабирования (после stop())
+    double wait_p99_ms() const { return wait_histogram.percentile(0.99) / 1000.0; }
+    double handler_seconds_used() const { return handler_seconds; }
+    double busy_handler_seconds() const { return TscClock::instance().to_ms(total_handle_ticks.load()) / 1000.0; }
+    std::uint64_t processed() const { return processed_packets.load(); }
+    std::uint64_t expired() const {
+        std::uint64_t total = 0;
+        for (int priority = 1; priority <= 5; ++priority) total += expired_packets[priority];
+        return total;
+    }
+    const LatencyHistogram& critical_latencies() const { return critical_latency; }
+
+    /*
+    Режим реального времени для критических пакетов (до start())
+    - handlers выделенных потоков с SCHED_FIFO (если разрешено),
+      память процесса закреплена через mlockall
+    - Очередь - кольцо фиксированной емкости, на пути обработки
+      нет выделений памяти и ввода-вывода
+    - Критический пакет проходит только проверку защиты (действующее
+      напряжение блока отсчетов); окна, кадры и гармоники его не видят
+     */
+    void enable_realtime(int handlers) {
+        realtime_handlers = handlers;
     }
 
     /*
@@ -70,10 +236,9 @@ public:
     Включает режим, при котором низкоприоритетные данные отбрасываются
      */
     void simulate_emergency() {
-        boost::unique_lock<boost::mutex> lock(data_mutex);
         emergency_mode = true;
         std::cout << "\n АВАРИЯ. Включен аварийный режим. Низкоприоритетные данные будут отбрасываться.\n";
-        lock.unlock();
+        Tracer::instance().global_instant("emergency", "mode");
     }
 
 private:
@@ -87,6 +252,11 @@ private:
         int priority;
         bool is_critical;
         int station_id;
+        std::uint64_t created_at;   // Метка TscClock создания (пакет сразу ставится в очередь)
+        std::uint32_t sequence;     // Порядковый номер пакета станции
+        std::int64_t event_time_ms; // Время события по часам станции
+        double voltage;             // Измеренное напряжение, В
+        int samples;                // Блок отсчетов в sample_pool, -1 - нет
 
         // Оператор сравнения для приоритетной очереди
         bool operator<(const DataPacket& other) const {
@@ -97,6 +267,11 @@ private:
             // Для данных одинаковой важности сравниваем приоритеты
             return priority > other.priority;
         }
+
+        // Класс для упакованного ключа кучи, тот же порядок, что и operator<
+        std::uint64_t queue_class() const {
+            return PackedKey::make_class(is_critical, priority);
+        }
     };
 
     /*
@@ -107,17 +282,26 @@ private:
         std::uniform_int_distribution<> priority_dist(1, 5);  // Приоритеты 1-5
         std::bernoulli_distribution critical_dist(0.15);      // 15% критических данных
         std::exponential_distribution<> interval_dist(1.0);   // Интервалы между отправками
+        std::normal_distribution<> voltage_dist(230.0, 2.0);  // Напряжение сети
+        std::uint32_t sequence = 0;
 
-        while (!shutdown) {
+        while (!data_packets.stopping()) {
             // Генерируем пакет данных
             int priority = priority_dist(gen);
             bool is_critical = critical_dist(gen);
             
             // Отправляем данные на сервер
-            add_data_packet(priority, is_critical, station_id);
+            std::int64_t event_time_ms = static_cast<std::int64_t>(
+                TscClock::instance().to_ms(TscClock::now() - start_ticks));
+            double voltage = voltage_dist(gen);
+            int samples = sample_pool.acquire();
+            if (samples >= 0) {
+                synthesize_samples(sample_pool.data(samples), sample_pool.size(), voltage, gen);
+            }
+            add_data_packet(priority, is_critical, station_id, sequence++, event_time_ms, voltage, samples);
             
             // Имитируем работу станции (случайный интервал)
-            double interval = interval_dist(gen);
+            double interval = interval_dist(gen) / send_rate.load();
             boost::this_thread::sleep_for(boost::chrono::milliseconds(static_cast<int>(interval * 1000)));
         }
     }
@@ -130,34 +314,43 @@ private:
     - Приоритетов данных
      */
     void server_handler() {
-        while (!shutdown) {
-            DataPacket packet;
-            {
-                boost::unique_lock<boost::mutex> lock(data_mutex);
-                // Ожидаем данные или сигнал завершения
-                while (data_packets.empty() && !shutdown) {
-                    data_condition.wait(lock);
-                }
-                if (shutdown) break;
+        Tracer::instance().name_thread("server");
+        DataPacket packet;
 
-                // Берем пакет с наивысшим приоритетом
-                packet = data_packets.top();
-                data_packets.pop();
+        // Сначала захватываем обработчик через семафор, затем берем пакет
+        // с наивысшим приоритетом: потоков больше, чем слотов, и пакет не
+        // ждет слота вне очереди; false - сигнал завершения работы
+        while (true) {
+            data_packets.acquire();
+            if (!data_packets.pop(packet)) {
+                data_packets.release();
+                break;
             }
 
-            // Захватываем обработчик через семафор
-            data_semaphore.wait();
+            // Устаревший пакет отбрасываем сразу, не обрабатывая
+            if (is_expired(packet)) {
+                expired_packets[packet.priority]++;
+                Tracer::instance().instant("expired", "server", "station", packet.station_id,
+                                           "priority", packet.priority);
+                sample_pool.release(packet.samples);
+                data_packets.release();
+                continue;
+            }
 
             // Проверяем текущую нагрузку
             int load = current_load.load();
-            
-            // При высокой нагрузке добавляем обработчики
-            if (load > 80 && additional_handlers < 3) {
-                boost::unique_lock<boost::mutex> lock(handler_mutex);
-                additional_handlers++;
-                data_semaphore.post(); // Добавляем новый обработчик
-                std::cout << "Нагрузка " << load << "%. Включен дополнительный обработчик. Всего: " 
-                          << (base_handlers + additional_handlers) << "\n";
+
+            // true - обработчик отключен, слот этого потока после пакета
+            // не возвращается в семафор
+            bool retire = false;
+            if (scaling_mode == ScalingMode::Reactive) {
+                // При высокой нагрузке добавляем обработчики
+                if (load > 80) {
+                    add_handler("Нагрузка " + std::to_string(load) + "%", load);
+                }
+            } else {
+                // Заранее подстраиваем обработчики под прогноз поступлений
+                retire = scale_to_forecast();
             }
 
             // В аварийном режиме проверяем приоритет
@@ -166,7 +359,10 @@ private:
                 if (packet.priority > 3 && !packet.is_critical) {
                     std::cout << "АВАРИЯ. Отброшен пакет от станции " << packet.station_id 
                               << " (приоритет: " << packet.priority << ")\n";
-                    data_semaphore.post();
+                    Tracer::instance().instant("drop", "server", "station", packet.station_id,
+                                               "priority", packet.priority);
+                    sample_pool.release(packet.samples);
+                    if (!retire) data_packets.release();
                     continue; // Пропускаем обработку этого пакета
                 }
                 
@@ -182,9 +378,49 @@ private:
                       << " (приоритет: " << packet.priority 
                       << ", критический: " << packet.is_critical << ")\n";
 
+            // Время ожидания пакета в очереди
+            std::uint64_t dispatched_at = TscClock::now();
+            std::uint64_t wait_ticks = dispatched_at - packet.created_at;
+            if (packet.is_critical) {
+                critical_latency.record(static_cast<std::uint64_t>(TscClock::instance().to_us(wait_ticks)));
+            }
+
             // Имитация обработки (чем выше нагрузка, тем дольше обработка)
             int processing_time = 100 + (rand() % 400) * (current_load / 100.0);
-            boost::this_thread::sleep_for(boost::chrono::milliseconds(processing_time));
+            {
+                TraceScope trace("packet", "server");
+                trace.arg("station", packet.station_id);
+                trace.arg("priority", packet.priority);
+                trace.arg("critical", packet.is_critical);
+                trace.arg("load", load);
+                trace.arg("wait_us", static_cast<std::int64_t>(TscClock::instance().to_us(wait_ticks)));
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(processing_time));
+            }
+
+            // Учет задержек обработанного пакета
+            processed_packets++;
+            total_handle_ticks += TscClock::now() - dispatched_at;
+            wait_histogram.record(static_cast<std::uint64_t>(TscClock::instance().to_us(wait_ticks)));
+
+            // Окна, кадры и гармоники общие для обработчиков
+            boost::unique_lock<boost::mutex> server_lock(server_mutex);
+            total_wait_ticks += wait_ticks;
+            if (wait_ticks > max_wait_ticks) max_wait_ticks = wait_ticks;
+
+            // Окна станции по времени событий; пакет опоздавший в закрытое окно не учитывается
+            windows.add(packet.station_id, packet.sequence, packet.event_time_ms, packet.is_critical);
+            windows.advance();
+
+            // Кадры показаний всех станций на одну метку времени
+            frames.add(packet.station_id, packet.event_time_ms, packet.voltage);
+            frames.expire(static_cast<std::int64_t>(TscClock::instance().to_ms(TscClock::now() - start_ticks)));
+
+            // Блок отсчетов уходит в пачку гармонического анализа
+            if (packet.samples >= 0) {
+                harmonics.add(packet.station_id, sample_pool.data(packet.samples));
+                sample_pool.release(packet.samples);
+            }
+            server_lock.unlock();
 
             // Обновляем нагрузку
             int new_load = load + (processing_time / 10);
@@ -192,45 +428,925 @@ private:
             current_load.store(new_load);
 
             // При низкой нагрузке отключаем дополнительные обработчики
-            if (new_load < 50 && additional_handlers > 0) {
-                boost::unique_lock<boost::mutex> lock(handler_mutex);
-                additional_handlers--;
-                data_semaphore.wait(); // Уменьшаем количество обработчиков
-                std::cout << "Нагрузка " << new_load << "%. Отключен обработчик. Всего: " 
-                          << (base_handlers + additional_handlers) << "\n";
+            if (scaling_mode == ScalingMode::Reactive && new_load < 50) {
+                retire = remove_handler("Нагрузка " + std::to_string(new_load) + "%", new_load) || retire;
             }
 
-            data_semaphore.post(); // Освобождаем обработчик
+            if (!retire) data_packets.release(); // Освобождаем обработчик
         }
     }
 
+    /*
+    Обработчик критических пакетов в режиме реального времени
+    Цикл не выделяет память и не пишет в поток вывода; трассировка
+    выключена по умолчанию и включается только для отладки
+     */
+    void critical_handler() {
+        prefault_stack<64 * 1024>();
+        if (set_thread_fifo(80)) realtime_fifo = true;
+        const TscClock& clock = TscClock::instance();
+        DataPacket packet;
+
+        while (critical_packets.pop(packet)) {
+            std::uint64_t dispatched_at = TscClock::now();
+            critical_latency.record(static_cast<std::uint64_t>(clock.to_us(dispatched_at - packet.created_at)));
+
+            // Защита: действующее напряжение вне 230 В +-10%
+            double rms = packet.voltage;
+            if (packet.samples >= 0) {
+                const float* samples = sample_pool.data(packet.samples);
+                double sum = 0.0;
+                for (int n = 0; n < sample_pool.size(); ++n) sum += samples[n] * samples[n];
+                rms = std::sqrt(sum / sample_pool.size());
+                sample_pool.release(packet.samples);
+            }
+            if (rms < 207.0 || rms > 253.0) protection_trips++;
+        }
+    }
+
+    /*
+    Включение и отключение дополнительного обработчика (не больше
+    max_additional_handlers); false - число обработчиков уже предельное
+    reason - причина для журнала, load - текущая нагрузка для трассировки
+    remove_handler вызывает поток обработчика, держащий слот: отключение -
+    это его слот, который он не вернет в семафор после пакета (ожидание
+    чужого слота под handler_mutex могло бы заблокировать все обработчики)
+     */
+    bool add_handler(const std::string& reason, int load) {
+        boost::unique_lock<boost::mutex> lock(handler_mutex);
+        if (additional_handlers >= max_additional_handlers) return false;
+        account_handler_time();
+        additional_handlers++;
+        data_packets.release(); // Добавляем новый обработчик
+        std::cout << reason << ". Включен дополнительный обработчик. Всего: " 
+                  << (base_handlers + additional_handlers) << "\n";
+        Tracer::instance().instant("handler_up", "handler", "load", load);
+        Tracer::instance().counter("handlers", base_handlers + additional_handlers);
+        return true;
+    }
+
+    bool remove_handler(const std::string& reason, int load) {
+        boost::unique_lock<boost::mutex> lock(handler_mutex);
+        if (additional_handlers <= 0) return false;
+        account_handler_time();
+        additional_handlers--;  // Слот вызывающего уходит из семафора
+        std::cout << reason << ". Отключен обработчик. Всего: " 
+                  << (base_handlers + additional_handlers) << "\n";
+        Tracer::instance().instant("handler_down", "handler", "load", load);
+        Tracer::instance().counter("handlers", base_handlers + additional_handlers);
+        return true;
+    }
+
+    /*
+    Учет обработчико-секунд с последнего изменения числа обработчиков
+     */
+    void account_handler_time() {
+        std::uint64_t now = TscClock::now();
+        handler_seconds += TscClock::instance().to_ms(now - handlers_changed_at) / 1000.0 *
+                           (base_handlers + additional_handlers);
+        handlers_changed_at = now;
+    }
+
+    /*
+    Масштабирование по прогнозу
+    - Раз в секунду прогнозу сообщается число поступлений за секунду
+    - Нужно столько обработчиков, чтобы прогноз на 2 с вперед занимал
+      не больше 80% их производительности (по средней длительности обработки)
+    Возвращает true, если обработчик отключен (см. remove_handler)
+     */
+    bool scale_to_forecast() {
+        const TscClock& clock = TscClock::instance();
+        boost::unique_lock<boost::mutex> lock(forecast_mutex);
+        std::uint64_t now = TscClock::now();
+        double elapsed_ms = clock.to_ms(now - forecast_sampled_at);
+        if (elapsed_ms >= 1000.0) {
+            std::uint64_t count = arrivals.load();
+            forecaster.observe((count - arrivals_sampled) * 1000.0 / elapsed_ms);
+            arrivals_sampled = count;
+            forecast_sampled_at = now;
+        }
+        if (!forecaster.ready()) return false;
+
+        std::uint64_t processed = processed_packets.load();
+        double handle_ms = processed > 0 ? clock.to_ms(total_handle_ticks.load()) / processed : 300.0;
+        double per_handler = 1000.0 / handle_ms;  // Пакетов в секунду на обработчик
+        double expected = forecaster.forecast(2.0);
+        lock.unlock();
+        int needed = static_cast<int>(std::ceil(expected / (0.8 * per_handler)));
+        int target = std::max(base_handlers, std::min(base_handlers + max_additional_handlers, needed));
+        int handlers = base_handlers + additional_handlers;
+
+        int load = current_load.load();
+        std::string reason = "Прогноз " + std::to_string(static_cast<int>(expected)) + " пакетов/с";
+        if (target > handlers) {
+            add_handler(reason, load);
+        } else if (target < handlers) {
+            return remove_handler(reason, load);
+        }
+        return false;
+    }
+
+    /*
+    Анализ выровненного кадра: разброс напряжения между станциями
+     */
+    void analyze_frame(const AlignedFrame& frame) {
+        double low = 0.0;
+        double high = 0.0;
+        bool first = true;
+        for (int station = 0; station < frame.stations; ++station) {
+            if (!frame.has[station]) continue;
+            double value = frame.values[station];
+            if (first || value < low) low = value;
+            if (first || value > high) high = value;
+            first = false;
+        }
+        if (high - low > max_voltage_spread) max_voltage_spread = high - low;
+        Tracer::instance().instant("frame", "frames", "present", frame.present,
+                                   "spread_mv", static_cast<std::int64_t>((high - low) * 1000));
+    }
+
+    /*
+    Отсчеты одного периода 50 Гц: основная гармоника с амплитудой
+    voltage * sqrt(2), 3-я, 5-я и 7-я гармоники до 4% и шум
+     */
+    static void synthesize_samples(float* samples, int count, double voltage, std::mt19937& gen) {
+        const double pi = 3.14159265358979323846;
+        std::uniform_real_distribution<> share_dist(0.0, 0.04);
+        std::normal_distribution<> noise_dist(0.0, 0.5);
+        double amplitude = voltage * std::sqrt(2.0);
+        double third = share_dist(gen), fifth = share_dist(gen), seventh = share_dist(gen);
+        for (int n = 0; n < count; ++n) {
+            double phase = 2 * pi * n / count;
+            samples[n] = static_cast<float>(amplitude * (std::sin(phase) + third * std::sin(3 * phase) +
+                                                         fifth * std::sin(5 * phase) +
+                                                         seventh * std::sin(7 * phase)) +
+                                            noise_dist(gen));
+        }
+    }
+
+    /*
+    Учет результата гармонического анализа блока
+     */
+    void record_harmonics(const HarmonicResult& result) {
+        thd_sum += result.thd;
+        if (result.thd > max_thd) max_thd = result.thd;
+        Tracer::instance().instant("harmonics", "harmonics", "station", result.station,
+                                   "thd_permille", static_cast<std::int64_t>(result.thd * 1000));
+    }
+
+    /*
+    Пакет старше максимального возраста своего приоритета
+     */
+    bool is_expired(const DataPacket& packet) const {
+        std::uint64_t max_age = max_age_ticks[packet.priority];
+        return max_age != 0 && TscClock::now() - packet.created_at > max_age;
+    }
+
 private:
-    // Очередь данных с приоритетом
-    std::priority_queue<DataPacket> data_packets;
+    // Диспетчер: 4-арная куча упакованных ключей пакетов, потоки
+    // обработчиков и семафор для контроля их числа
+    Dispatcher<DataPacket, PackedQueuePolicy<DataPacket, 4>, BlockingIdle, 2> data_packets;
     
-    // Потоки станций мониторинга и сервера
+    // Потоки станций мониторинга
     boost::thread_group station_threads;
-    boost::thread server_thread;
     
     // Синхронизация
-    boost::mutex data_mutex;        // Для доступа к очереди данных
     boost::mutex handler_mutex;     // Для управления обработчиками
-    boost::condition_variable data_condition; // Для ожидания данных
-    boost::interprocess::interprocess_semaphore data_semaphore; // Контроль обработчиков
+    boost::mutex server_mutex;      // Окна, кадры, гармоники и суммы ожидания
+    boost::mutex forecast_mutex;    // Замеры поступлений для прогноза
     
     // Состояние системы
     std::atomic<int> current_load;  // Текущая нагрузка (0-100%)
     std::atomic<int> additional_handlers; // Дополнительные обработчики
-    std::atomic<bool> shutdown{false};    // Флаг завершения работы
     std::atomic<bool> emergency_mode{false}; // Аварийный режим
+    std::atomic<double> send_rate{1.0};      // Множитель частоты отправки станций
+    
+    // Задержки обработанных пакетов (тики TscClock; ожидание - под server_mutex)
+    std::atomic<std::uint64_t> processed_packets{0};
+    std::uint64_t total_wait_ticks = 0;    // Ожидание в очереди
+    std::atomic<std::uint64_t> total_handle_ticks{0};  // Обработка, сумма по обработчикам
+    std::uint64_t max_wait_ticks = 0;
+    std::atomic<std::uint64_t> expired_packets[6] = {};  // Отброшено по возрасту, по приоритетам
+    
+    // Максимальный возраст пакета по приоритетам, тики TscClock (0 - без ограничения)
+    std::uint64_t max_age_ticks[6] = {};
     
     // Константы
     const int max_load;       // Максимальная нагрузка (100%)
     const int base_handlers;  // Базовое количество обработчиков (2)
+    static const int max_additional_handlers = 3;  // Дополнительных обработчиков не больше
+    static const int station_count = 10;  // Станций мониторинга
+    
+    // Время запуска системы - начало отсчета времени событий станций
+    const std::uint64_t start_ticks;
+    
+    // Окна станций по времени событий (под server_mutex)
+    StationWindows windows;
+    
+    // Выравнивание показаний станций по кадрам (под server_mutex)
+    AlignmentBuffer frames;
+    double max_voltage_spread = 0.0;  // Наибольший разброс напряжения в кадре, В
+    
+    // Блоки отсчетов пакетов и их гармонический анализ (анализ - под server_mutex)
+    SampleBlockPool sample_pool;
+    HarmonicStage harmonics;
+    double thd_sum = 0.0;  // Сумма КНИ по блокам
+    double max_thd = 0.0;
+    
+    // Масштабирование обработчиков
+    ScalingMode scaling_mode = ScalingMode::Reactive;
+    std::atomic<std::uint64_t> arrivals{0};   // Всего поступивших пакетов
+    ArrivalForecaster forecaster;             // Прогноз поступлений в секунду
+    std::uint64_t arrivals_sampled = 0;       // arrivals на момент последнего замера
+    std::uint64_t forecast_sampled_at = 0;    // Метка TscClock последнего замера
+    std::uint64_t handlers_changed_at = 0;    // Метка TscClock изменения числа обработчиков
+    double handler_seconds = 0.0;             // Обработчико-секунд с запуска
+    LatencyHistogram wait_histogram;          // Ожидание в очереди, мкс
+    
+    // Режим реального времени для критических пакетов
+    int realtime_handlers = 0;                // 0 - режим выключен
+    Dispatcher<DataPacket, RingQueuePolicy<DataPacket, 256>, BlockingIdle, 0> critical_packets;
+    std::atomic<bool> realtime_fifo{false};   // Хотя бы один поток получил SCHED_FIFO
+    bool memory_locked = false;               // mlockall выполнен в start()
+    std::atomic<std::uint64_t> protection_trips{0};
+    LatencyHistogram critical_latency;        // От создания до обработчика, мкс (оба режима)
 };
 
-int main() {
+/*
+Вывод итогов прогона модели в виртуальном времени
+ */
+void print_grid_stats(const char* name, const GridStats& stats, double seconds) {
+    std::cout << name << ": событий " << stats.events
+              << ", обработано " << stats.processed
+              << ", переслано " << stats.forwarded
+              << ", отброшено " << stats.dropped
+              << ", среднее ожидание " << (stats.processed ? stats.wait_sum / stats.processed : 0.0) << " с"
+              << ", время " << seconds << " с"
+              << " (" << (seconds > 0 ? stats.events / seconds : 0.0) << " событий/с)\n";
+}
+
+/*
+Прогон модели (последовательной или параллельной) с замером реального времени
+ */
+template <typename Simulator, typename... Args>
+GridStats run_grid_model(const char* name, double& seconds, const Args&... args) {
+    boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+    Simulator simulator(args...);
+    simulator.run();
+    GridStats stats = simulator.stats();
+    seconds = boost::chrono::duration<double>(boost::chrono::steady_clock::now() - begin).count();
+    print_grid_stats(name, stats, seconds);
+    return stats;
+}
+
+/*
+Последовательный прогон на календарной очереди и на куче, затем
+параллельные на 2..max_processes логических процессах; итоги всех
+прогонов должны совпадать. Возвращает false при расхождении
+ */
+bool run_des_benchmark(const GridConfig& config, int max_processes) {
+    std::cout << "Модель энергосети: " << config.stations << " станций, "
+              << config.regions << " регионов, " << config.duration << " с\n";
+    double sequential_time = 0.0;
+    double heap_time = 0.0;
+    GridStats sequential = run_grid_model<GridSimulator<CalendarQueue>>(
+        "Календарная очередь", sequential_time, config);
+    GridStats heap = run_grid_model<GridSimulator<BinaryHeapEventList>>("Двоичная куча", heap_time, config);
+    bool same = heap == sequential;
+    if (!same) std::cout << "  итоги кучи РАСХОДЯТСЯ с календарной очередью\n";
+
+    // Параллельный прогон на 2-32 логических процессах
+    for (int processes = 2; processes <= max_processes; processes *= 2) {
+        double parallel_time = 0.0;
+        std::string name = "Параллельно, процессов " + std::to_string(processes);
+        GridStats parallel = run_grid_model<ParallelGridSimulator<CalendarQueue>>(
+            name.c_str(), parallel_time, config, processes);
+        same = same && parallel == sequential;
+        std::cout << "  ускорение " << (parallel_time > 0 ? sequential_time / parallel_time : 0.0)
+                  << ", итоги " << (parallel == sequential ? "совпадают" : "РАСХОДЯТСЯ")
+                  << " с последовательным прогоном\n";
+    }
+    return same;
+}
+
+/*
+Событие модели задач квантового симулятора (1.cpp)
+ */
+struct QuantumEvent {
+    enum Kind { Arrival, Completion, Repair } kind;
+    int site;        // Номер симулятора
+    int processor;   // Для завершения
+    int generation;  // Поколение процессора при начале задачи
+};
+
+/*
+Итоги модели задач квантового симулятора
+ */
+struct QuantumStats {
+    std::uint64_t events = 0;
+    std::uint64_t completed = 0;
+    std::uint64_t failures = 0;
+    std::uint64_t lost = 0;       // Задач, прерванных сбоем и возвращенных в очередь
+    std::uint64_t max_pending = 0;
+
+    bool operator==(const QuantumStats& other) const {
+        return events == other.events && completed == other.completed && failures == other.failures &&
+               lost == other.lost && max_pending == other.max_pending;
+    }
+};
+
+/*
+Распределения QuantumSimulator в виртуальном времени: sites независимых
+симуляторов по 4 процессора
+- Поступления - экспоненциальные интервалы в среднем 200 мс (как в main 1.cpp)
+- Выполнение - равномерно 500-1500 мс
+- При начале задачи с вероятностью 10% сбой случайного процессора;
+  задача на нем прерывается и возвращается в очередь
+- Ремонт всех процессоров симулятора каждые 4 с
+Порядок событий (time, tag) одинаков для любого списка событий,
+поэтому итоги разных списков должны совпадать
+ */
+template <template <typename> class EventList>
+QuantumStats run_quantum_model(int sites, double duration, double& seconds) {
+    struct Site {
+        int waiting = 0;
+        bool busy[4] = {};
+        bool failed[4] = {};
+        int generation[4] = {};
+    };
+    std::mt19937_64 gen(1);
+    std::exponential_distribution<> arrival_dist(1.0 / 0.2);
+    std::uniform_real_distribution<> work_dist(0.5, 1.5);
+    std::bernoulli_distribution failure_dist(0.1);
+    std::uniform_int_distribution<> processor_dist(0, 3);
+
+    boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+    EventList<QuantumEvent> events;
+    std::vector<Site> state(sites);
+    std::uint64_t tag = 0;
+    QuantumStats stats;
+    for (int site = 0; site < sites; ++site) {
+        events.push(arrival_dist(gen), tag++, QuantumEvent{QuantumEvent::Arrival, site, -1, 0});
+        events.push(4.0, tag++, QuantumEvent{QuantumEvent::Repair, site, -1, 0});
+    }
+
+    // Начало ожидающих задач на свободных исправных процессорах
+    auto start_tasks = [&](double now, int site) {
+        Site& s = state[site];
+        while (s.waiting > 0) {
+            if (failure_dist(gen)) {
+                int victim = processor_dist(gen);
+                if (!s.failed[victim]) {
+                    s.failed[victim] = true;
+                    s.generation[victim]++;
+                    stats.failures++;
+                    if (s.busy[victim]) {
+                        s.busy[victim] = false;
+                        s.waiting++;
+                        stats.lost++;
+                    }
+                }
+            }
+            int processor = -1;
+            for (int i = 0; i < 4 && processor < 0; ++i) {
+                if (!s.busy[i] && !s.failed[i]) processor = i;
+            }
+            if (processor < 0) return;
+            s.waiting--;
+            s.busy[processor] = true;
+            events.push(now + work_dist(gen), tag++,
+                        QuantumEvent{QuantumEvent::Completion, site, processor, s.generation[processor]});
+        }
+    };
+
+    while (!events.empty()) {
+        typename EventList<QuantumEvent>::Entry entry = events.pop();
+        if (entry.time > duration) break;
+        stats.events++;
+        if (events.size() > stats.max_pending) stats.max_pending = events.size();
+        const QuantumEvent& event = entry.event;
+        Site& s = state[event.site];
+        switch (event.kind) {
+        case QuantumEvent::Arrival:
+            s.waiting++;
+            events.push(entry.time + arrival_dist(gen), tag++, QuantumEvent{QuantumEvent::Arrival, event.site, -1, 0});
+            break;
+        case QuantumEvent::Completion:
+            // Завершение задачи, прерванной сбоем, устарело
+            if (event.generation != s.generation[event.processor]) continue;
+            s.busy[event.processor] = false;
+            stats.completed++;
+            break;
+        case QuantumEvent::Repair:
+            for (int i = 0; i < 4; ++i) s.failed[i] = false;
+            events.push(entry.time + 4.0, tag++, QuantumEvent{QuantumEvent::Repair, event.site, -1, 0});
+            break;
+        }
+        start_tasks(entry.time, event.site);
+    }
+    seconds = boost::chrono::duration<double>(boost::chrono::steady_clock::now() - begin).count();
+    return stats;
+}
+
+/*
+Календарная очередь против двоичной кучи на модели задач квантового симулятора
+Возвращает false при расхождении итогов
+ */
+bool run_quantum_event_benchmark(int sites, double duration) {
+    std::cout << "Модель задач квантового симулятора: " << sites << " симуляторов по 4 процессора, "
+              << duration << " с\n";
+    double calendar_time = 0.0, heap_time = 0.0;
+    QuantumStats calendar = run_quantum_model<CalendarQueue>(sites, duration, calendar_time);
+    QuantumStats heap = run_quantum_model<BinaryHeapEventList>(sites, duration, heap_time);
+    const char* names[] = {"Календарная очередь", "Двоичная куча"};
+    const QuantumStats* results[] = {&calendar, &heap};
+    const double times[] = {calendar_time, heap_time};
+    for (int i = 0; i < 2; ++i) {
+        std::cout << names[i] << ": событий " << results[i]->events
+                  << ", выполнено " << results[i]->completed
+                  << ", сбоев " << results[i]->failures
+                  << " (прервано задач " << results[i]->lost << ")"
+                  << ", до " << results[i]->max_pending << " событий в списке"
+                  << ", время " << times[i] << " с"
+                  << " (" << (times[i] > 0 ? results[i]->events / times[i] : 0.0) << " событий/с)\n";
+    }
+    bool same = calendar == heap;
+    std::cout << "  итоги " << (same ? "совпадают" : "РАСХОДЯТСЯ") << "\n";
+    return same;
+}
+
+/*
+Элемент для сравнения очередей: те же поля, что у задачи и пакета
+ */
+struct QueueBenchItem {
+    int priority;
+    bool is_critical;
+    int id;
+
+    bool operator<(const QueueBenchItem& other) const {
+        if (is_critical != other.is_critical) return !is_critical;
+        return priority > other.priority;
+    }
+
+    std::uint64_t heap_key() const {
+        return (static_cast<std::uint64_t>(!is_critical) << 63) | (static_cast<std::uint64_t>(priority) << 32);
+    }
+
+    std::uint64_t queue_class() const { return PackedKey::make_class(is_critical, priority); }
+};
+
+/*
+Замер очереди в установившемся режиме: size элементов в очереди,
+operations пар извлечение + добавление; bytes - байт на элемент
+ */
+template <typename Policy>
+void run_queue_benchmark(const char* name, int size, int operations, std::size_t bytes) {
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<> priority_dist(1, 5);
+    std::bernoulli_distribution critical_dist(0.15);
+    Policy queue;
+    for (int i = 0; i < size; ++i) queue.push(QueueBenchItem{priority_dist(gen), critical_dist(gen), i});
+
+    std::vector<QueueBenchItem> arrivals(4096);
+    for (QueueBenchItem& item : arrivals) item = QueueBenchItem{priority_dist(gen), critical_dist(gen), 0};
+
+    std::uint64_t begin = TscClock::now();
+    long checksum = 0;
+    for (int i = 0; i < operations; ++i) {
+        checksum += queue.take().id;
+        queue.push(arrivals[i & 4095]);
+    }
+    double ns = TscClock::instance().to_ns(TscClock::now() - begin);
+    std::cout << name << ": " << ns / operations << " нс на пару операций, "
+              << bytes << " байт на элемент (контроль " << checksum % 1000 << ")\n";
+}
+
+/*
+Элемент для замера диспетчера: метка TscClock постановки в очередь
+ */
+struct DispatchBenchItem : QueueBenchItem {
+    std::uint64_t created_at;
+};
+
+/*
+Замер сочетания политик диспетчера: поток-источник кладет пачки по 16
+элементов и ждет, пока consumers рабочих потоков их разберут
+Пачка меньше емкости кольца, поэтому push подходит и для RingQueuePolicy
+Выводит элементов в секунду и задержку от push до извлечения
+ */
+template <typename Policy, typename Idle>
+void run_dispatch_benchmark(const char* name, int consumers, int bursts) {
+    const int burst = 16;
+    Dispatcher<DispatchBenchItem, Policy, Idle, 0> dispatcher;
+    std::atomic<std::uint64_t> taken{0};
+    LatencyHistogram latency;  // нс
+    const TscClock& clock = TscClock::instance();
+    dispatcher.start(consumers, [&](int) {
+        DispatchBenchItem item;
+        while (dispatcher.pop(item)) {
+            latency.record(static_cast<std::uint64_t>(clock.to_ns(TscClock::now() - item.created_at)));
+            taken++;
+        }
+    });
+
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<> priority_dist(1, 5);
+    std::bernoulli_distribution critical_dist(0.15);
+    std::uint64_t begin = TscClock::now();
+    std::uint64_t pushed = 0;
+    for (int i = 0; i < bursts; ++i) {
+        for (int k = 0; k < burst; ++k) {
+            DispatchBenchItem item;
+            item.priority = priority_dist(gen);
+            item.is_critical = critical_dist(gen);
+            item.id = static_cast<int>(pushed++);
+            item.created_at = TscClock::now();
+            dispatcher.push(item);
+        }
+        while (taken.load() < pushed) boost::this_thread::yield();
+    }
+    double seconds = clock.to_ms(TscClock::now() - begin) / 1000.0;
+    dispatcher.stop();
+
+    std::cout << name << ": " << (seconds > 0 ? pushed / seconds : 0.0) << " элементов/с"
+              << ", задержка p50 " << latency.percentile(0.5) << " нс"
+              << ", p99 " << latency.percentile(0.99) << " нс\n";
+}
+
+/*
+Все сочетания политик очереди и ожидания
+ */
+template <typename Idle>
+void run_dispatch_benchmarks(const std::string& idle, int consumers, int bursts) {
+    run_dispatch_benchmark<PriorityQueuePolicy<DispatchBenchItem>, Idle>(
+        ("Двоичная куча, " + idle).c_str(), consumers, bursts);
+    run_dispatch_benchmark<FifoQueuePolicy<DispatchBenchItem>, Idle>(
+        ("FIFO, " + idle).c_str(), consumers, bursts);
+    run_dispatch_benchmark<RingQueuePolicy<DispatchBenchItem, 256>, Idle>(
+        ("Кольцо, " + idle).c_str(), consumers, bursts);
+    run_dispatch_benchmark<DaryHeapQueuePolicy<DispatchBenchItem, 4>, Idle>(
+        ("4-арная куча, " + idle).c_str(), consumers, bursts);
+    run_dispatch_benchmark<PackedQueuePolicy<DispatchBenchItem, 4>, Idle>(
+        ("Упакованные ключи, " + idle).c_str(), consumers, bursts);
+}
+
+/*
+Пакет синтетического потока: время события и время прихода, мс
+ */
+struct LateBenchPacket {
+    std::int64_t arrival_ms;
+    std::int64_t event_time_ms;
+    int station;
+    std::uint32_t sequence;
+};
+
+/*
+Пропускная способность окон станций в зависимости от допустимого опоздания
+Поток заранее сгенерирован: stations станций по 10 пакетов в секунду
+в течение seconds с, задержка доставки экспоненциальная (в среднем 300 мс),
+у 2% пакетов - еще до 5 с (перегрузка сети); пакеты подаются в порядке прихода
+ */
+void run_lateness_benchmark(int stations, int seconds) {
+    std::mt19937 gen(1);
+    std::exponential_distribution<> delay_dist(1.0 / 300.0);
+    std::bernoulli_distribution stall_dist(0.02);
+    std::uniform_int_distribution<> stall_ms_dist(0, 5000);
+    std::vector<LateBenchPacket> packets;
+    packets.reserve(static_cast<std::size_t>(stations) * seconds * 10);
+    for (int station = 0; station < stations; ++station) {
+        std::uint32_t sequence = 0;
+        for (std::int64_t event = station % 100; event < seconds * 1000; event += 100) {
+            std::int64_t delay = static_cast<std::int64_t>(delay_dist(gen));
+            if (stall_dist(gen)) delay += stall_ms_dist(gen);
+            packets.push_back(LateBenchPacket{event + delay, event, station, sequence++});
+        }
+    }
+    std::stable_sort(packets.begin(), packets.end(), [](const LateBenchPacket& a, const LateBenchPacket& b) {
+        return a.arrival_ms < b.arrival_ms;
+    });
+
+    std::cout << "Окна станций: " << stations << " станций, пакетов " << packets.size()
+              << ", окно 1000 мс, до 8 открытых окон на станцию\n";
+    const int lateness[] = {0, 250, 500, 1000, 2000, 4000};
+    for (int allowed : lateness) {
+        StationWindows windows(stations, 1000, allowed, 8, StationWindows::Sink());
+        std::uint64_t begin = TscClock::now();
+        for (const LateBenchPacket& packet : packets) {
+            windows.add(packet.station, packet.sequence, packet.event_time_ms, false);
+            windows.advance();
+        }
+        double elapsed = TscClock::instance().to_ms(TscClock::now() - begin) / 1000.0;
+        std::cout << "Опоздание " << allowed << " мс: " << (elapsed > 0 ? packets.size() / elapsed : 0.0)
+                  << " пакетов/с, опоздавших " << 100.0 * windows.late / packets.size() << "%"
+                  << ", окон закрыто " << windows.finalized
+                  << ", принудительно " << windows.forced << "\n";
+    }
+}
+
+/*
+Показание синтетического потока для выравнивания
+ */
+struct FrameBenchReading {
+    std::int64_t arrival_ms;
+    std::int64_t event_time_ms;
+    int station;
+    double value;
+};
+
+/*
+Кадров в секунду у буфера выравнивания: stations станций присылают
+показание на каждый кадр 20 мс (50 кадров/с) в течение seconds с
+Задержка доставки экспоненциальная (в среднем 5 мс), в 5% кадров одна
+станция теряет показание - такие кадры закрываются по таймауту 60 мс;
+показания подаются в порядке прихода, поток сгенерирован заранее
+ */
+void run_frames_benchmark(int stations, int seconds) {
+    const std::int64_t frame_ms = 20;
+    std::mt19937 gen(1);
+    std::exponential_distribution<> delay_dist(1.0 / 5.0);
+    std::bernoulli_distribution loss_dist(0.05);
+    std::uniform_int_distribution<> station_dist(0, stations - 1);
+    std::normal_distribution<> voltage_dist(230.0, 2.0);
+    std::vector<FrameBenchReading> readings;
+    readings.reserve(static_cast<std::size_t>(stations) * seconds * (1000 / frame_ms));
+    for (std::int64_t event = 0; event < seconds * 1000; event += frame_ms) {
+        int lost = loss_dist(gen) ? station_dist(gen) : -1;
+        for (int station = 0; station < stations; ++station) {
+            if (station == lost) continue;
+            std::int64_t arrival = event + static_cast<std::int64_t>(delay_dist(gen));
+            readings.push_back(FrameBenchReading{arrival, event, station, voltage_dist(gen)});
+        }
+    }
+    std::stable_sort(readings.begin(), readings.end(), [](const FrameBenchReading& a, const FrameBenchReading& b) {
+        return a.arrival_ms < b.arrival_ms;
+    });
+
+    // Анализ кадра как у системы мониторинга - разброс по всем станциям
+    double max_spread = 0.0;
+    AlignmentBuffer frames(stations, frame_ms, 60, 8, [&max_spread](const AlignedFrame& frame) {
+        double low = 1e9, high = -1e9;
+        for (int station = 0; station < frame.stations; ++station) {
+            if (!frame.has[station]) continue;
+            low = std::min(low, frame.values[station]);
+            high = std::max(high, frame.values[station]);
+        }
+        if (high - low > max_spread) max_spread = high - low;
+    });
+    std::uint64_t begin = TscClock::now();
+    for (const FrameBenchReading& reading : readings) {
+        frames.add(reading.station, reading.event_time_ms, reading.value);
+        frames.expire(reading.arrival_ms);
+    }
+    frames.expire(seconds * 1000 + 1000);
+    double elapsed = TscClock::instance().to_ms(TscClock::now() - begin) / 1000.0;
+
+    std::uint64_t emitted = frames.complete_frames + frames.partial_frames;
+    std::cout << "Выравнивание: " << stations << " станций, показаний " << readings.size()
+              << ", кадр " << frame_ms << " мс\n"
+              << "Кадров: полных " << frames.complete_frames << ", по таймауту " << frames.partial_frames
+              << " (досрочно " << frames.evicted << "), опоздавших показаний " << frames.late << "\n"
+              << (elapsed > 0 ? emitted / elapsed : 0.0) << " кадров/с, "
+              << (elapsed > 0 ? readings.size() / elapsed : 0.0) << " показаний/с"
+              << " (макс. разброс " << max_spread << " В)\n";
+}
+
+/*
+Масштабирование по нагрузке против масштабирования по прогнозу на
+одинаковом всплеске: 5 с обычной частоты, 5 с плавного роста до
+4-кратной, 5 с всплеска, 5 с обычной частоты
+ */
+void run_scaling_benchmark() {
+    const ScalingMode modes[] = {ScalingMode::Reactive, ScalingMode::Predictive};
+    double p99[2], handler_seconds[2], busy[2];
+    std::uint64_t processed[2];
+    for (int i = 0; i < 2; ++i) {
+        EnergyMonitorSystem system;
+        system.set_scaling_mode(modes[i]);
+        system.start();
+        for (int step = 0; step < 40; ++step) {
+            double rate = step < 10 ? 1.0 : step < 20 ? 1.0 + 3.0 * (step - 9) / 10.0 : step < 30 ? 4.0 : 1.0;
+            system.set_send_rate(rate);
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+        }
+        system.stop();
+        p99[i] = system.wait_p99_ms();
+        handler_seconds[i] = system.handler_seconds_used();
+        busy[i] = system.busy_handler_seconds();
+        processed[i] = system.processed();
+    }
+    std::cout << "\nВсплеск поступлений:\n";
+    const char* names[] = {"По нагрузке", "По прогнозу"};
+    for (int i = 0; i < 2; ++i) {
+        std::cout << names[i] << ": обработано " << processed[i] << ", p99 ожидания " << p99[i]
+                  << " мс, обработчико-секунд выделено " << handler_seconds[i] << ", занято " << busy[i] << "\n";
+    }
+}
+
+/*
+Разброс задержки критических пакетов: обычный режим (через сервер)
+против режима реального времени, seconds с работы в каждом при
+частоте отправки rate (множитель set_send_rate)
+Задержка - от создания пакета до начала его обработки, мкс
+ */
+void run_jitter_benchmark(int seconds, double rate) {
+    std::uint64_t p99[2], p9999[2], worst[2], count[2];
+    for (int realtime = 0; realtime < 2; ++realtime) {
+        EnergyMonitorSystem system;
+        if (realtime) system.enable_realtime(2);
+        system.set_send_rate(rate);
+        system.start();
+        boost::this_thread::sleep_for(boost::chrono::seconds(seconds));
+        system.stop();
+        const LatencyHistogram& latency = system.critical_latencies();
+        p99[realtime] = latency.percentile(0.99);
+        p9999[realtime] = latency.percentile(0.9999);
+        worst[realtime] = latency.max();
+        count[realtime] = latency.count();
+    }
+    std::cout << "\nЗадержка критических пакетов, мкс:\n";
+    const char* names[] = {"Обычный режим", "Реальное время"};
+    for (int realtime = 0; realtime < 2; ++realtime) {
+        std::cout << names[realtime] << ": пакетов " << count[realtime] << ", p99 " << p99[realtime]
+                  << ", p99.99 " << p9999[realtime] << ", максимум " << worst[realtime] << "\n";
+    }
+}
+
+/*
+Перегрузка с отбрасыванием устаревших пакетов и без него: станции
+отправляют в rate раз чаще обычного (больше, чем успевают обработчики),
+seconds с в каждом прогоне; занятость обработчиков - измеренное время
+обработки, а не оценка по числу отброшенных
+ */
+void run_overload_benchmark(int seconds, double rate) {
+    const char* names[] = {"Без ограничения возраста", "С ограничением возраста"};
+    std::uint64_t processed[2], expired[2];
+    double busy[2], p99[2];
+    for (int expiry = 0; expiry < 2; ++expiry) {
+        EnergyMonitorSystem system;
+        if (!expiry) {
+            for (int priority = 1; priority <= 5; ++priority) system.set_max_age(priority, 0);
+        }
+        system.set_send_rate(rate);
+        system.start();
+        boost::this_thread::sleep_for(boost::chrono::seconds(seconds));
+        system.stop();
+        processed[expiry] = system.processed();
+        expired[expiry] = system.expired();
+        busy[expiry] = system.busy_handler_seconds();
+        p99[expiry] = system.wait_p99_ms();
+    }
+    std::cout << "\nПерегрузка, частота отправки x" << rate << ", " << seconds << " с:\n";
+    for (int expiry = 0; expiry < 2; ++expiry) {
+        std::cout << names[expiry] << ": обработано " << processed[expiry] << ", отброшено " << expired[expiry]
+                  << ", занято обработчиков " << busy[expiry] << " с"
+                  << " (" << (processed[expiry] > 0 ? 1000.0 * busy[expiry] / processed[expiry] : 0.0)
+                  << " мс на пакет), p99 ожидания " << p99[expiry] << " мс\n";
+    }
+}
+
+/*
+Пропускная способность гармонического анализа без станций: blocks блоков
+по 64 отсчета (1 период, гармоники 1-15) из 1024 заранее заполненных,
+при разных размерах пачки; время - только add/flush этапа
+ */
+void run_harmonics_benchmark(int blocks) {
+    const int block_size = 64;
+    const int prepared = 1024;
+    const double pi = 3.14159265358979323846;
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<> share_dist(0.0, 0.04);
+    std::normal_distribution<> noise_dist(0.0, 0.5);
+    std::vector<float> samples(static_cast<std::size_t>(prepared) * block_size);
+    for (int block = 0; block < prepared; ++block) {
+        double amplitude = 230.0 * std::sqrt(2.0);
+        double third = share_dist(gen), fifth = share_dist(gen);
+        for (int n = 0; n < block_size; ++n) {
+            double phase = 2 * pi * n / block_size;
+            samples[static_cast<std::size_t>(block) * block_size + n] = static_cast<float>(
+                amplitude * (std::sin(phase) + third * std::sin(3 * phase) + fifth * std::sin(5 * phase)) +
+                noise_dist(gen));
+        }
+    }
+
+    std::cout << "Гармонический анализ: блоков " << blocks << " по " << block_size << " отсчетов\n";
+    const int batches[] = {1, 4, 16, 64};
+    for (int batch : batches) {
+        double thd_sum = 0.0;
+        HarmonicStage stage(block_size, 1, batch, 15,
+                            [&thd_sum](const HarmonicResult& result) { thd_sum += result.thd; });
+        std::uint64_t begin = TscClock::now();
+        for (int i = 0; i < blocks; ++i) {
+            stage.add(i % 10000, &samples[static_cast<std::size_t>(i % prepared) * block_size]);
+        }
+        stage.flush();
+        double elapsed = TscClock::instance().to_ms(TscClock::now() - begin) / 1000.0;
+        double busy = TscClock::instance().to_ms(stage.busy_ticks) / 1000.0;
+        std::cout << "Пачка " << batch << ": " << (elapsed > 0 ? blocks / elapsed : 0.0) << " блоков/с"
+                  << " (БПФ и анализ " << (busy > 0 ? blocks / busy : 0.0) << " блоков/с)"
+                  << ", средний КНИ " << 100.0 * thd_sum / blocks << "%\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Сравнение очередей: 2 queue [элементов в очереди]
+    if (argc > 1 && std::string(argv[1]) == "queue") {
+        int size = argc > 2 ? std::atoi(argv[2]) : 10000;
+        int operations = 2000000;
+        std::cout << "Очереди с приоритетом, элементов: " << size << "\n";
+        run_queue_benchmark<PriorityQueuePolicy<QueueBenchItem>>(
+            "Двоичная куча структур", size, operations, sizeof(QueueBenchItem));
+        run_queue_benchmark<DaryHeapQueuePolicy<QueueBenchItem, 4>>(
+            "4-арная куча, ключ + индекс", size, operations,
+            sizeof(std::uint64_t) + sizeof(std::uint32_t) + sizeof(QueueBenchItem));
+        run_queue_benchmark<PackedQueuePolicy<QueueBenchItem, 4>>(
+            "4-арная куча упакованных ключей", size, operations,
+            sizeof(std::uint64_t) + sizeof(QueueBenchItem));
+        return 0;
+    }
+
+    // Сочетания политик диспетчера: 2 dispatch [рабочих потоков] [пачек]
+    if (argc > 1 && std::string(argv[1]) == "dispatch") {
+        int consumers = argc > 2 ? std::atoi(argv[2]) : 2;
+        int bursts = argc > 3 ? std::atoi(argv[3]) : 20000;
+        std::cout << "Диспетчер: рабочих потоков " << consumers << ", пачек по 16 элементов " << bursts << "\n";
+        run_dispatch_benchmarks<BlockingIdle>("ожидание", consumers, bursts);
+        run_dispatch_benchmarks<SpinThenBlockIdle<64>>("64 уступки, затем ожидание", consumers, bursts);
+        TunableSpinIdle::spin_count().store(16);
+        run_dispatch_benchmarks<TunableSpinIdle>("16 уступок (настраиваемо)", consumers, bursts);
+        return 0;
+    }
+
+    // Окна станций и допустимое опоздание: 2 lateness [станций] [секунд]
+    if (argc > 1 && std::string(argv[1]) == "lateness") {
+        run_lateness_benchmark(argc > 2 ? std::atoi(argv[2]) : 1000, argc > 3 ? std::atoi(argv[3]) : 60);
+        return 0;
+    }
+
+    // Кадры выравнивания: 2 frames [станций] [секунд]
+    if (argc > 1 && std::string(argv[1]) == "frames") {
+        run_frames_benchmark(argc > 2 ? std::atoi(argv[2]) : 10000, argc > 3 ? std::atoi(argv[3]) : 10);
+        return 0;
+    }
+
+    // Масштабирование на всплеске, по нагрузке и по прогнозу: 2 scaling
+    if (argc > 1 && std::string(argv[1]) == "scaling") {
+        run_scaling_benchmark();
+        return 0;
+    }
+
+    // Разброс задержки критических пакетов: 2 jitter [секунд] [частота отправки]
+    if (argc > 1 && std::string(argv[1]) == "jitter") {
+        run_jitter_benchmark(argc > 2 ? std::atoi(argv[2]) : 10, argc > 3 ? std::atof(argv[3]) : 20.0);
+        return 0;
+    }
+
+    // Перегрузка с отбрасыванием устаревших пакетов и без: 2 overload [секунд] [частота отправки]
+    if (argc > 1 && std::string(argv[1]) == "overload") {
+        run_overload_benchmark(argc > 2 ? std::atoi(argv[2]) : 10, argc > 3 ? std::atof(argv[3]) : 10.0);
+        return 0;
+    }
+
+    // Пропускная способность гармонического анализа: 2 harmonics [блоков]
+    if (argc > 1 && std::string(argv[1]) == "harmonics") {
+        run_harmonics_benchmark(argc > 2 ? std::atoi(argv[2]) : 2000000);
+        return 0;
+    }
+
+    // Режим виртуального времени: 2 des [станций] [секунд модели] [макс. потоков]
+    if (argc > 1 && std::string(argv[1]) == "des") {
+        GridConfig config;
+        if (argc > 2) config.stations = std::atoi(argv[2]);
+        if (argc > 3) config.duration = std::atof(argv[3]);
+        int max_processes = argc > 4 ? std::atoi(argv[4]) : 32;
+        config.regions = std::max(1, config.stations / 5);  // ~75% загрузки региона
+        bool same = run_des_benchmark(config, max_processes);
+
+        // Перегрузка: очереди регионов переполняются, пакеты пересылаются
+        // между логическими процессами - проверка обмена на барьерах
+        config.regions = std::max(1, config.stations / 8);  // ~120% загрузки региона
+        std::cout << "\nС пересылками между регионами\n";
+        same = run_des_benchmark(config, max_processes) && same;
+
+        // Распределения поступлений, выполнения и ремонта задач 1.cpp
+        std::cout << "\n";
+        same = run_quantum_event_benchmark(config.stations, config.duration) && same;
+        return same ? 0 : 1;
+    }
+
+    // Трассировка временной шкалы: TRACE_FILE=trace.json
+    if (const char* trace_file = std::getenv("TRACE_FILE")) {
+        Tracer::instance().start(trace_file);
+    }
+
     EnergyMonitorSystem system;
+    // 2 [predictive] [realtime]
+    // predictive - масштабирование обработчиков по прогнозу поступлений
+    // realtime - критические пакеты обрабатывают 2 потока реального времени
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "predictive") system.set_scaling_mode(ScalingMode::Predictive);
+        if (option == "realtime") system.enable_realtime(2);
+    }
     std::cout << "Запуск системы мониторинга энергосети" << std::endl;
     system.start();
 
@@ -246,6 +1362,7 @@ int main() {
     // Завершение работы
     std::cout << "\n Остановка системы мониторинга" << std::endl;
     system.stop();
+    Tracer::instance().stop();
     
     return 0;
 }
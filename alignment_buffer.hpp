@@ -0,0 +1,126 @@
+#ifndef ALIGNMENT_BUFFER_HPP
+#define ALIGNMENT_BUFFER_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+/*
+Кадр показаний всех станций на одну метку времени
+Массивы принадлежат буферу и действительны только внутри вызова sink
+ */
+struct AlignedFrame {
+    std::int64_t timestamp_ms;  // Начало кадра во времени событий
+    int stations;
+    int present;                // Станций с показаниями
+    bool complete;              // Все станции, иначе кадр закрыт по таймауту
+    const double* values;       // values[station]
+    const std::uint8_t* has;    // has[station] != 0 - показание есть
+};
+
+/*
+Буфер выравнивания показаний станций по времени (как у синхрофазоров)
+- Время событий делится на кадры длины frame_ms
+- depth ячеек кадров с массивами фиксированного размера по номеру станции,
+  память выделяется один раз, на пакет выделений нет
+- Кадр отдается в sink, как только пришли все станции, или по таймауту
+  timeout_ms после конца кадра (по времени событий) с неполным набором
+- Если для нового кадра нет свободной ячейки, самый старый кадр
+  отдается досрочно как неполный
+ */
+class AlignmentBuffer {
+public:
+    typedef std::function<void(const AlignedFrame&)> Sink;
+
+    AlignmentBuffer(int stations, std::int64_t frame_ms, std::int64_t timeout_ms, int depth, Sink sink) :
+        sink(sink),
+        stations(stations),
+        frame_ms(frame_ms),
+        timeout_ms(timeout_ms),
+        frames(depth),
+        values(static_cast<std::size_t>(stations) * depth, 0.0),
+        has(static_cast<std::size_t>(stations) * depth, 0)
+    {}
+
+    /*
+    Показание value станции station на момент event_time_ms
+     */
+    void add(int station, std::int64_t event_time_ms, double value) {
+        std::int64_t index = event_time_ms / frame_ms;
+        int slot = static_cast<int>(index % frames.size());
+        Frame& frame = frames[slot];
+        if (frame.index != index && (index < next_index || index < frame.index)) {
+            late++;
+            return;
+        }
+
+        if (frame.index != index) {
+            if (frame.index >= 0) {
+                evicted++;
+                emit(slot, false);
+            }
+            open(slot, index);
+        }
+
+        std::size_t cell = static_cast<std::size_t>(slot) * stations + station;
+        values[cell] = value;  // Повтор станции в кадре заменяет прежнее показание
+        if (!has[cell]) {
+            has[cell] = 1;
+            if (++frame.present == stations) emit(slot, true);
+        }
+    }
+
+    /*
+    Закрытие кадров, ожидающих дольше таймаута; now_ms - текущее время событий
+     */
+    void expire(std::int64_t now_ms) {
+        for (int slot = 0; slot < static_cast<int>(frames.size()); ++slot) {
+            const Frame& frame = frames[slot];
+            if (frame.index >= 0 && now_ms - (frame.index + 1) * frame_ms > timeout_ms) {
+                emit(slot, false);
+            }
+        }
+    }
+
+    // Счетчики
+    std::uint64_t complete_frames = 0;
+    std::uint64_t partial_frames = 0;
+    std::uint64_t late = 0;       // Показаний для уже отданных кадров
+    std::uint64_t evicted = 0;    // Кадров, отданных досрочно из-за нехватки ячеек
+
+private:
+    struct Frame {
+        std::int64_t index = -1;  // Номер кадра, -1 - ячейка свободна
+        int present = 0;
+    };
+
+    void open(int slot, std::int64_t index) {
+        frames[slot].index = index;
+        frames[slot].present = 0;
+        std::size_t first = static_cast<std::size_t>(slot) * stations;
+        std::fill(has.begin() + first, has.begin() + first + stations, 0);
+    }
+
+    void emit(int slot, bool complete) {
+        Frame& frame = frames[slot];
+        std::size_t first = static_cast<std::size_t>(slot) * stations;
+        AlignedFrame aligned{frame.index * frame_ms, stations, frame.present, complete,
+                             &values[first], &has[first]};
+        if (complete) complete_frames++; else partial_frames++;
+        if (frame.index + 1 > next_index) next_index = frame.index + 1;
+        if (sink) sink(aligned);
+        frame.index = -1;
+    }
+
+    Sink sink;
+    int stations;
+    std::int64_t frame_ms;
+    std::int64_t timeout_ms;
+    std::int64_t next_index = 0;       // Кадры с меньшими номерами, кроме открытых, уже отданы
+    std::vector<Frame> frames;
+    std::vector<double> values;        // depth x stations
+    std::vector<std::uint8_t> has;     // depth x stations
+};
+
+#endif
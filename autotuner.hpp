@@ -0,0 +1,162 @@
+#ifndef AUTOTUNER_HPP
+#define AUTOTUNER_HPP
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <functional>
+#include <boost/thread.hpp>
+#include <boost/chrono.hpp>
+#include "trace.hpp"
+
+/*
+Фоновая автонастройка параметров восхождением по одной координате
+- Каждый период measure() возвращает оценку работы за период (больше - лучше)
+- Пробный шаг одного параметра держится период; если оценка выросла больше
+  чем на threshold - шаг принимается и повторяется в ту же сторону,
+  иначе параметр возвращается, направление меняется, очередь переходит
+  к следующему параметру
+- После отката период измеряется заново - нагрузка могла измениться
+- Значения не выходят из [min, max]; каждое решение пишется в журнал
+- Если ни один параметр не может сдвинуться (min == max), поток
+  настройки завершается
+ */
+class Autotuner {
+public:
+    typedef std::function<double()> Measure;
+    typedef std::function<void(int)> Apply;
+
+    Autotuner(int period_ms, double threshold, Measure measure) :
+        period_ms(period_ms),
+        threshold(threshold),
+        measure(measure)
+    {}
+
+    ~Autotuner() { stop(); }
+
+    /*
+    Параметр name с начальным значением initial (уже примененным)
+    apply вызывается из потока настройки при каждом изменении
+     */
+    void add_knob(const char* name, int initial, int min, int max, int step, Apply apply) {
+        knobs.push_back(Knob{name, initial, min, max, step, 1, apply});
+    }
+
+    void start() {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (running || knobs.empty()) return;
+        running = true;
+        thread = boost::thread(&Autotuner::run, this);
+    }
+
+    void stop() {
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (!running) return;
+            running = false;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+
+    int value(int knob) const { return knobs[knob].value; }
+
+    // Включение журнала решений (по умолчанию включен)
+    bool verbose = true;
+
+    // Счетчики
+    int trials = 0;    // Пробных шагов
+    int accepted = 0;  // Принятых шагов
+
+private:
+    struct Knob {
+        const char* name;
+        int value;
+        int min;
+        int max;
+        int step;
+        int direction;  // +1 или -1
+        Apply apply;
+    };
+
+    // Ожидание периода; false - настройка остановлена
+    bool wait_period() {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        condition.wait_for(lock, boost::chrono::milliseconds(period_ms), [this] { return !running; });
+        return running;
+    }
+
+    void run() {
+        int current = 0;
+        int pinned = 0;  // Параметров подряд, которые некуда сдвинуть
+        if (!wait_period()) return;
+        double baseline = measure();
+
+        while (true) {
+            Knob& knob = knobs[current];
+            int previous = knob.value;
+            int candidate = clamp(knob, previous + knob.direction * knob.step);
+            if (candidate == previous) {
+                knob.direction = -knob.direction;
+                candidate = clamp(knob, previous + knob.direction * knob.step);
+            }
+            if (candidate == previous) {
+                if (++pinned == static_cast<int>(knobs.size())) return;
+                current = (current + 1) % static_cast<int>(knobs.size());
+                continue;
+            }
+            pinned = 0;
+
+            set(knob, candidate);
+            trials++;
+            if (!wait_period()) {
+                set(knob, previous);  // Непроверенный шаг не оставляем
+                return;
+            }
+            double score = measure();
+
+            if (score > baseline * (1.0 + threshold)) {
+                accepted++;
+                log(knob, previous, candidate, baseline, score, true);
+                baseline = score;
+                continue;
+            }
+
+            log(knob, previous, candidate, baseline, score, false);
+            set(knob, previous);
+            knob.direction = -knob.direction;
+            current = (current + 1) % static_cast<int>(knobs.size());
+            if (!wait_period()) return;
+            baseline = measure();
+        }
+    }
+
+    static int clamp(const Knob& knob, int value) {
+        return value < knob.min ? knob.min : value > knob.max ? knob.max : value;
+    }
+
+    void set(Knob& knob, int value) {
+        knob.value = value;
+        knob.apply(value);
+        Tracer::instance().counter(knob.name, value);
+    }
+
+    void log(const Knob& knob, int from, int to, double before, double after, bool accept) {
+        if (!verbose) return;
+        std::cout << "Автонастройка: " << knob.name << " " << from << " -> " << to
+                  << ", оценка " << before << " -> " << after
+                  << (accept ? ", принято\n" : ", откат\n");
+    }
+
+    int period_ms;
+    double threshold;     // Минимальный относительный прирост оценки
+    Measure measure;
+    std::vector<Knob> knobs;
+
+    boost::mutex mutex;
+    boost::condition_variable condition;
+    boost::thread thread;
+    bool running = false;
+};
+
+#endif
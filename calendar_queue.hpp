@@ -0,0 +1,194 @@
+#ifndef CALENDAR_QUEUE_HPP
+#define CALENDAR_QUEUE_HPP
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+/*
+Запись списка событий: время, ключ для разрешения равенства времен и событие
+Порядок (time, tag) не зависит от порядка вставки, поэтому прогон
+детерминирован при любом разбиении модели
+ */
+template <typename Event>
+struct ScheduledEvent {
+    double time;
+    std::uint64_t tag;
+    Event event;
+
+    bool operator<(const ScheduledEvent& other) const {
+        if (time != other.time) return time < other.time;
+        return tag < other.tag;
+    }
+};
+
+/*
+Календарная очередь (R. Brown, 1988) для списка событий
+- Время делится на "дни" ширины width, дни раскладываются по nb корзинам
+- Вставка и извлечение в среднем O(1), корзины короткие
+- Число корзин удваивается/уменьшается вдвое вместе с числом событий,
+  ширина дня пересчитывается по среднему интервалу между ближайшими событиями
+ */
+template <typename Event>
+class CalendarQueue {
+public:
+    typedef ScheduledEvent<Event> Entry;
+
+    CalendarQueue() : buckets(2), width(1.0), now(0.0), current(0), current_day(0), count(0) {}
+
+    /*
+    Событие раньше последнего извлеченного (возврат в список, пересылка
+    другого логического процесса) переводит текущий день назад к нему -
+    иначе просмотр с текущего дня вернул бы более позднее событие раньше
+     */
+    void push(double time, std::uint64_t tag, const Event& event) {
+        if (time < now) {
+            now = time;
+            current_day = day_of(time);
+            current = current_day % buckets.size();
+        }
+        insert(Entry{time, tag, event});
+        ++count;
+        if (count > 2 * buckets.size()) resize(2 * buckets.size());
+    }
+
+    /*
+    Извлечение ближайшего события
+     */
+    Entry pop() {
+        // Просматриваем корзины текущего "года" начиная с текущего дня
+        for (std::size_t i = 0; i < buckets.size(); ++i) {
+            std::vector<Entry>& bucket = buckets[current];
+            if (!bucket.empty() && day_of(bucket.back().time) <= current_day) {
+                return take(bucket);
+            }
+            current = (current + 1) % buckets.size();
+            ++current_day;
+        }
+
+        // За год событий нет: прямой поиск минимума среди всех корзин
+        std::size_t best = buckets.size();
+        for (std::size_t i = 0; i < buckets.size(); ++i) {
+            if (buckets[i].empty()) continue;
+            if (best == buckets.size() || buckets[i].back() < buckets[best].back()) best = i;
+        }
+        current = best;
+        current_day = day_of(buckets[best].back().time);
+        return take(buckets[best]);
+    }
+
+    bool empty() const { return count == 0; }
+    std::size_t size() const { return count; }
+
+private:
+    std::uint64_t day_of(double time) const {
+        return static_cast<std::uint64_t>(time / width);
+    }
+
+    /*
+    Корзина отсортирована по убыванию: ближайшее событие в конце
+     */
+    void insert(const Entry& entry) {
+        std::vector<Entry>& bucket = buckets[day_of(entry.time) % buckets.size()];
+        auto position = std::upper_bound(bucket.begin(), bucket.end(), entry,
+            [](const Entry& a, const Entry& b) { return b < a; });
+        bucket.insert(position, entry);
+    }
+
+    Entry take(std::vector<Entry>& bucket) {
+        Entry entry = bucket.back();
+        bucket.pop_back();
+        --count;
+        now = entry.time;
+        if (buckets.size() > 2 && count < buckets.size() / 2) {
+            resize(buckets.size() / 2);
+        }
+        return entry;
+    }
+
+    /*
+    Перестройка календаря под новое число корзин
+    Событий раньше now нет (push переводит now назад), поэтому отсчет
+    дней начинается с него
+     */
+    void resize(std::size_t bucket_count) {
+        std::vector<Entry> entries;
+        entries.reserve(count);
+        for (std::vector<Entry>& bucket : buckets) {
+            entries.insert(entries.end(), bucket.begin(), bucket.end());
+        }
+
+        width = estimate_width(entries);
+        buckets.assign(bucket_count, std::vector<Entry>());
+        for (const Entry& entry : entries) {
+            insert(entry);
+        }
+
+        current_day = day_of(now);
+        current = current_day % buckets.size();
+    }
+
+    /*
+    Ширина дня - трижды средний интервал между ближайшими событиями,
+    без учета выбросов больше двух средних
+     */
+    double estimate_width(std::vector<Entry> entries) const {
+        std::size_t sample = std::min<std::size_t>(entries.size(), 25);
+        if (sample < 2) return width;
+        std::partial_sort(entries.begin(), entries.begin() + sample, entries.end());
+
+        double average = (entries[sample - 1].time - entries[0].time) / (sample - 1);
+        double total = 0.0;
+        int used = 0;
+        for (std::size_t i = 1; i < sample; ++i) {
+            double gap = entries[i].time - entries[i - 1].time;
+            if (gap <= 2.0 * average) {
+                total += gap;
+                ++used;
+            }
+        }
+        if (used == 0 || total <= 0.0) return width;
+        return 3.0 * total / used;
+    }
+
+    std::vector<std::vector<Entry>> buckets;
+    double width;              // Ширина одного дня
+    double now;                // Время последнего извлеченного события (или более раннего добавленного)
+    std::size_t current;       // Корзина текущего дня
+    std::uint64_t current_day; // Номер текущего дня
+    std::size_t count;         // Число событий
+};
+
+/*
+Список событий на двоичной куче с тем же интерфейсом,
+для сравнения с календарной очередью
+ */
+template <typename Event>
+class BinaryHeapEventList {
+public:
+    typedef ScheduledEvent<Event> Entry;
+
+    void push(double time, std::uint64_t tag, const Event& event) {
+        heap.push(Entry{time, tag, event});
+    }
+
+    Entry pop() {
+        Entry entry = heap.top();
+        heap.pop();
+        return entry;
+    }
+
+    bool empty() const { return heap.empty(); }
+    std::size_t size() const { return heap.size(); }
+
+private:
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const { return b < a; }
+    };
+
+    std::priority_queue<Entry, std::vector<Entry>, Later> heap;
+};
+
+#endif
@@ -0,0 +1,356 @@
+#ifndef CIRCUIT_HPP
+#define CIRCUIT_HPP
+
+#include <vector>
+#include <array>
+#include <complex>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+/*
+Вектор состояния n кубитов: 2^n комплексных амплитуд
+Кубит q соответствует биту q индекса амплитуды
+Real - тип частей амплитуды: float вдвое сокращает память и объем
+проходов по ней ценой точности (~1e-7 на вентиль); матрицы вентилей
+всегда двойной точности и приводятся к Real при применении
+ */
+template <typename Real>
+class BasicStateVector {
+public:
+    typedef Real Scalar;
+    typedef std::complex<Real> Amplitude;
+    typedef std::array<std::complex<double>, 4> Matrix2;  // Строки: m[0] m[1] / m[2] m[3]
+
+    explicit BasicStateVector(int qubits = 0) { reset(qubits); }
+
+    /*
+    Состояние |0...0>; память переиспользуется, если размер не растет
+     */
+    void reset(int qubits) {
+        qubit_count = qubits;
+        amplitudes.assign(std::size_t(1) << qubits, Amplitude(0.0, 0.0));
+        amplitudes[0] = Amplitude(1.0, 0.0);
+    }
+
+    int qubits() const { return qubit_count; }
+    std::size_t size() const { return amplitudes.size(); }
+    const Amplitude& operator[](std::size_t index) const { return amplitudes[index]; }
+    Amplitude* data() { return amplitudes.data(); }
+
+    /*
+    Умножение на вещественных частях: std::complex * проверяет NaN
+    и не векторизуется
+     */
+    void apply_single(int target, const Matrix2& matrix) {
+        Real mr[4], mi[4];
+        for (int k = 0; k < 4; ++k) {
+            mr[k] = static_cast<Real>(matrix[k].real());
+            mi[k] = static_cast<Real>(matrix[k].imag());
+        }
+        Real* values = reinterpret_cast<Real*>(amplitudes.data());
+        std::size_t stride = std::size_t(1) << target;
+        for (std::size_t base = 0; base < amplitudes.size(); base += 2 * stride) {
+            Real* low = values + 2 * base;
+            Real* high = low + 2 * stride;
+            for (std::size_t i = 0; i < stride; ++i) {
+                Real r0 = low[2 * i], i0 = low[2 * i + 1];
+                Real r1 = high[2 * i], i1 = high[2 * i + 1];
+                low[2 * i] = mr[0] * r0 - mi[0] * i0 + mr[1] * r1 - mi[1] * i1;
+                low[2 * i + 1] = mr[0] * i0 + mi[0] * r0 + mr[1] * i1 + mi[1] * r1;
+                high[2 * i] = mr[2] * r0 - mi[2] * i0 + mr[3] * r1 - mi[3] * i1;
+                high[2 * i + 1] = mr[2] * i0 + mi[2] * r0 + mr[3] * i1 + mi[3] * r1;
+            }
+        }
+    }
+
+    /*
+    Двухкубитные вентили проходят только четверть индексов, где control = 1
+    и target = 0: номер k четверти раздвигается нулевыми битами на местах
+    обоих кубитов
+     */
+    void apply_cx(int control, int target) {
+        std::size_t control_bit = std::size_t(1) << control;
+        std::size_t target_bit = std::size_t(1) << target;
+        int low = control < target ? control : target;
+        int high = control < target ? target : control;
+        for (std::size_t k = 0; k < amplitudes.size() / 4; ++k) {
+            std::size_t i = insert_zero(insert_zero(k, low), high) | control_bit;
+            std::swap(amplitudes[i], amplitudes[i | target_bit]);
+        }
+    }
+
+    void apply_cz(int control, int target) {
+        std::size_t mask = (std::size_t(1) << control) | (std::size_t(1) << target);
+        int low = control < target ? control : target;
+        int high = control < target ? target : control;
+        for (std::size_t k = 0; k < amplitudes.size() / 4; ++k) {
+            std::size_t i = insert_zero(insert_zero(k, low), high) | mask;
+            amplitudes[i] = -amplitudes[i];
+        }
+    }
+
+    /*
+    Среднее значение Z на кубите qubit
+     */
+    double expectation_z(int qubit) const {
+        std::size_t bit = std::size_t(1) << qubit;
+        double sum = 0.0;
+        for (std::size_t i = 0; i < amplitudes.size(); ++i) {
+            sum += (i & bit ? -1.0 : 1.0) * std::norm(amplitudes[i]);
+        }
+        return sum;
+    }
+
+private:
+    // Вставка нулевого бита на место bit: младшие биты остаются, старшие сдвигаются
+    static std::size_t insert_zero(std::size_t value, int bit) {
+        std::size_t low_mask = (std::size_t(1) << bit) - 1;
+        return ((value & ~low_mask) << 1) | (value & low_mask);
+    }
+
+    int qubit_count = 0;
+    std::vector<Amplitude> amplitudes;
+};
+
+typedef BasicStateVector<double> StateVector;
+typedef BasicStateVector<float> StateVectorFloat;
+
+/*
+Вентили схемы
+ */
+enum class GateKind { H, X, Y, Z, S, RX, RY, RZ, CX, CZ };
+
+struct GateSpec {
+    GateKind kind;
+    int target;
+    int control;     // Для CX, CZ, иначе -1
+    int parameter;   // Номер параметра угла, -1 - угол фиксирован
+    double angle;    // Фиксированный угол
+};
+
+class CompiledCircuit;
+
+/*
+Параметризованная схема: последовательность вентилей, углы поворотов
+задаются числами или номерами параметров, значения которых
+подставляются при каждом запуске
+ */
+class ParameterizedCircuit {
+public:
+    explicit ParameterizedCircuit(int qubits) : qubit_count(qubits) {}
+
+    void h(int q) { add(GateKind::H, q); }
+    void x(int q) { add(GateKind::X, q); }
+    void y(int q) { add(GateKind::Y, q); }
+    void z(int q) { add(GateKind::Z, q); }
+    void s(int q) { add(GateKind::S, q); }
+    void cx(int control, int target) { gates.push_back(GateSpec{GateKind::CX, target, control, -1, 0.0}); }
+    void cz(int control, int target) { gates.push_back(GateSpec{GateKind::CZ, target, control, -1, 0.0}); }
+
+    // Поворот на фиксированный угол
+    void rx(int q, double angle) { rotation(GateKind::RX, q, -1, angle); }
+    void ry(int q, double angle) { rotation(GateKind::RY, q, -1, angle); }
+    void rz(int q, double angle) { rotation(GateKind::RZ, q, -1, angle); }
+
+    // Поворот на угол параметра parameter
+    void rx_param(int q, int parameter) { rotation(GateKind::RX, q, parameter, 0.0); }
+    void ry_param(int q, int parameter) { rotation(GateKind::RY, q, parameter, 0.0); }
+    void rz_param(int q, int parameter) { rotation(GateKind::RZ, q, parameter, 0.0); }
+
+    int qubits() const { return qubit_count; }
+    int parameters() const { return parameter_count; }
+    const std::vector<GateSpec>& gate_list() const { return gates; }
+
+    CompiledCircuit compile() const;
+
+private:
+    void add(GateKind kind, int q) { gates.push_back(GateSpec{kind, q, -1, -1, 0.0}); }
+
+    void rotation(GateKind kind, int q, int parameter, double angle) {
+        gates.push_back(GateSpec{kind, q, -1, parameter, angle});
+        if (parameter + 1 > parameter_count) parameter_count = parameter + 1;
+    }
+
+    int qubit_count;
+    int parameter_count = 0;
+    std::vector<GateSpec> gates;
+};
+
+/*
+Скомпилированная схема
+- Подряд идущие однокубитные вентили одного кубита (между двухкубитными
+  на этом кубите) сливаются в одно ядро 2x2
+- Ядра без параметров перемножаются при компиляции
+- Ядра с параметрами хранят список своих вентилей; при привязке параметров
+  (bind) перемножаются только они, без повторной компиляции
+- Объект неизменяем после компиляции и общий для потоков; матрицы
+  привязки лежат в буфере вызывающего
+ */
+class CompiledCircuit {
+public:
+    typedef StateVector::Matrix2 Matrix2;
+
+    int qubits() const { return qubit_count; }
+    int parameters() const { return parameter_count; }
+    std::size_t kernels() const { return kernel_list.size(); }
+    std::size_t gates() const { return gate_count; }
+
+    /*
+    Матрицы ядер для значений параметров params (parameters() чисел)
+    matrices переиспользуется между вызовами
+     */
+    void bind(const double* params, std::vector<Matrix2>& matrices) const {
+        matrices.resize(kernel_list.size());
+        for (std::size_t k = 0; k < kernel_list.size(); ++k) {
+            const Kernel& kernel = kernel_list[k];
+            if (kernel.type != Kernel::Single) continue;
+            if (!kernel.parametric) {
+                matrices[k] = kernel.fixed;
+                continue;
+            }
+            Matrix2 product = identity();
+            for (int op = kernel.first_op; op < kernel.first_op + kernel.op_count; ++op) {
+                product = multiply(gate_matrix(ops[op], params), product);
+            }
+            matrices[k] = product;
+        }
+    }
+
+    /*
+    Применение схемы с привязанными матрицами к состоянию
+    State - любое представление с apply_single, apply_cx, apply_cz
+    (вектор состояния, MPS)
+     */
+    template <typename State>
+    void execute(State& state, const std::vector<Matrix2>& matrices) const {
+        execute(state, matrices, 0, kernel_list.size());
+    }
+
+    /*
+    Применение ядер [first, last) - выполнение по частям, например
+    с контрольными точками между частями
+     */
+    template <typename State>
+    void execute(State& state, const std::vector<Matrix2>& matrices, std::size_t first, std::size_t last) const {
+        for (std::size_t k = first; k < last; ++k) {
+            const Kernel& kernel = kernel_list[k];
+            switch (kernel.type) {
+            case Kernel::Single: state.apply_single(kernel.target, matrices[k]); break;
+            case Kernel::ControlledX: state.apply_cx(kernel.control, kernel.target); break;
+            case Kernel::ControlledZ: state.apply_cz(kernel.control, kernel.target); break;
+            }
+        }
+    }
+
+    /*
+    Запуск с нуля: |0...0>, привязка params, применение
+     */
+    template <typename State>
+    void run(State& state, const double* params, std::vector<Matrix2>& matrices) const {
+        state.reset(qubit_count);
+        bind(params, matrices);
+        execute(state, matrices);
+    }
+
+    static Matrix2 gate_matrix(const GateSpec& gate, const double* params) {
+        typedef std::complex<double> C;
+        const double r = 1.0 / std::sqrt(2.0);
+        double angle = gate.parameter >= 0 ? params[gate.parameter] : gate.angle;
+        double c = std::cos(angle / 2), s = std::sin(angle / 2);
+        switch (gate.kind) {
+        case GateKind::H: return Matrix2{{C(r), C(r), C(r), C(-r)}};
+        case GateKind::X: return Matrix2{{C(0), C(1), C(1), C(0)}};
+        case GateKind::Y: return Matrix2{{C(0), C(0, -1), C(0, 1), C(0)}};
+        case GateKind::Z: return Matrix2{{C(1), C(0), C(0), C(-1)}};
+        case GateKind::S: return Matrix2{{C(1), C(0), C(0), C(0, 1)}};
+        case GateKind::RX: return Matrix2{{C(c), C(0, -s), C(0, -s), C(c)}};
+        case GateKind::RY: return Matrix2{{C(c), C(-s), C(s), C(c)}};
+        case GateKind::RZ: return Matrix2{{C(c, -s), C(0), C(0), C(c, s)}};
+        default: return identity();
+        }
+    }
+
+private:
+    friend class ParameterizedCircuit;
+
+    struct Kernel {
+        enum Type { Single, ControlledX, ControlledZ } type;
+        int target;
+        int control;
+        int first_op;     // Вентили ядра: ops[first_op .. first_op + op_count)
+        int op_count;
+        bool parametric;
+        Matrix2 fixed;    // Произведение для ядра без параметров
+    };
+
+    static Matrix2 identity() {
+        return Matrix2{{1.0, 0.0, 0.0, 1.0}};
+    }
+
+    // a * b: сначала применяется b, затем a
+    static Matrix2 multiply(const Matrix2& a, const Matrix2& b) {
+        return Matrix2{{a[0] * b[0] + a[1] * b[2], a[0] * b[1] + a[1] * b[3],
+                        a[2] * b[0] + a[3] * b[2], a[2] * b[1] + a[3] * b[3]}};
+    }
+
+    int qubit_count = 0;
+    int parameter_count = 0;
+    std::size_t gate_count = 0;
+    std::vector<Kernel> kernel_list;
+    std::vector<GateSpec> ops;        // Вентили однокубитных ядер, по ядрам подряд
+};
+
+inline CompiledCircuit ParameterizedCircuit::compile() const {
+    typedef CompiledCircuit::Kernel Kernel;
+    CompiledCircuit compiled;
+    compiled.qubit_count = qubit_count;
+    compiled.parameter_count = parameter_count;
+    compiled.gate_count = gates.size();
+
+    // Группы однокубитных вентилей: ядро открыто, пока на кубит
+    // не пришел двухкубитный вентиль
+    std::vector<int> open(qubit_count, -1);
+    std::vector<std::vector<GateSpec>> groups;
+    for (const GateSpec& gate : gates) {
+        if (gate.kind == GateKind::CX || gate.kind == GateKind::CZ) {
+            open[gate.control] = -1;
+            open[gate.target] = -1;
+            Kernel kernel = Kernel();
+            kernel.type = gate.kind == GateKind::CX ? Kernel::ControlledX : Kernel::ControlledZ;
+            kernel.target = gate.target;
+            kernel.control = gate.control;
+            compiled.kernel_list.push_back(kernel);
+            groups.emplace_back();
+            continue;
+        }
+        if (open[gate.target] < 0) {
+            Kernel kernel = Kernel();
+            kernel.type = Kernel::Single;
+            kernel.target = gate.target;
+            kernel.control = -1;
+            open[gate.target] = static_cast<int>(compiled.kernel_list.size());
+            compiled.kernel_list.push_back(kernel);
+            groups.emplace_back();
+        }
+        groups[open[gate.target]].push_back(gate);
+    }
+
+    // Вентили ядер подряд; ядра без параметров перемножаются сразу
+    for (std::size_t k = 0; k < compiled.kernel_list.size(); ++k) {
+        Kernel& kernel = compiled.kernel_list[k];
+        if (kernel.type != Kernel::Single) continue;
+        kernel.first_op = static_cast<int>(compiled.ops.size());
+        kernel.op_count = static_cast<int>(groups[k].size());
+        kernel.parametric = false;
+        kernel.fixed = CompiledCircuit::identity();
+        for (const GateSpec& gate : groups[k]) {
+            compiled.ops.push_back(gate);
+            if (gate.parameter >= 0) kernel.parametric = true;
+            else kernel.fixed = CompiledCircuit::multiply(CompiledCircuit::gate_matrix(gate, nullptr), kernel.fixed);
+        }
+    }
+    return compiled;
+}
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef DARY_HEAP_HPP
+#define DARY_HEAP_HPP
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+/*
+Неявная d-арная куча (минимум на вершине)
+- Ключи (64 бита) и индексы полезной нагрузки лежат в отдельных массивах,
+  поэтому просеивание читает только плотный массив ключей
+- Полезная нагрузка хранится в пуле и не перемещается при просеивании
+- Arity 4 или 8: дети одного узла помещаются в одну-две кеш-линии
+ */
+template <typename Payload, int Arity = 4>
+class DaryHeap {
+    static_assert(Arity >= 2, "Arity должна быть не меньше 2");
+
+public:
+    void push(std::uint64_t key, const Payload& payload) {
+        std::uint32_t slot;
+        if (free_slots.empty()) {
+            slot = static_cast<std::uint32_t>(payloads.size());
+            payloads.push_back(payload);
+        } else {
+            slot = free_slots.back();
+            free_slots.pop_back();
+            payloads[slot] = payload;
+        }
+
+        keys.push_back(key);
+        slots.push_back(slot);
+        sift_up(keys.size() - 1);
+    }
+
+    /*
+    Извлечение элемента с минимальным ключом
+     */
+    Payload pop() {
+        std::uint32_t slot = slots[0];
+        Payload payload = payloads[slot];
+        free_slots.push_back(slot);
+
+        keys[0] = keys.back();
+        slots[0] = slots.back();
+        keys.pop_back();
+        slots.pop_back();
+        if (!keys.empty()) sift_down(0);
+        return payload;
+    }
+
+    std::uint64_t top_key() const { return keys[0]; }
+    const Payload& top() const { return payloads[slots[0]]; }
+    bool empty() const { return keys.empty(); }
+    std::size_t size() const { return keys.size(); }
+
+    void reserve(std::size_t count) {
+        keys.reserve(count);
+        slots.reserve(count);
+        payloads.reserve(count);
+    }
+
+private:
+    void sift_up(std::size_t index) {
+        std::uint64_t key = keys[index];
+        std::uint32_t slot = slots[index];
+        while (index > 0) {
+            std::size_t parent = (index - 1) / Arity;
+            if (keys[parent] <= key) break;
+            keys[index] = keys[parent];
+            slots[index] = slots[parent];
+            index = parent;
+        }
+        keys[index] = key;
+        slots[index] = slot;
+    }
+
+    void sift_down(std::size_t index) {
+        std::uint64_t key = keys[index];
+        std::uint32_t slot = slots[index];
+        std::size_t size = keys.size();
+        while (true) {
+            std::size_t first = index * Arity + 1;
+            if (first >= size) break;
+
+            // Ищем минимального ребенка среди Arity соседних ключей
+            std::size_t last = first + Arity < size ? first + Arity : size;
+            std::size_t best = first;
+            for (std::size_t child = first + 1; child < last; ++child) {
+                if (keys[child] < keys[best]) best = child;
+            }
+            if (key <= keys[best]) break;
+
+            keys[index] = keys[best];
+            slots[index] = slots[best];
+            index = best;
+        }
+        keys[index] = key;
+        slots[index] = slot;
+    }
+
+    std::vector<std::uint64_t> keys;       // Ключи в порядке кучи
+    std::vector<std::uint32_t> slots;      // Индексы полезной нагрузки
+    std::vector<Payload> payloads;         // Пул полезной нагрузки
+    std::vector<std::uint32_t> free_slots; // Свободные ячейки пула
+};
+
+/*
+Политика очереди диспетчера на основе d-арной кучи
+Item должен предоставлять heap_key(): меньший ключ извлекается первым
+ */
+template <typename Item, int Arity = 4>
+class DaryHeapQueuePolicy {
+public:
+    void push(const Item& item) { heap.push(item.heap_key(), item); }
+    Item take() { return heap.pop(); }
+    bool empty() const { return heap.empty(); }
+    std::size_t size() const { return heap.size(); }
+
+private:
+    DaryHeap<Item, Arity> heap;
+};
+
+/*
+Упакованный 64-битный ключ элемента очереди (меньше - раньше)
+- бит 63: элемент некритический
+- биты 59-62: приоритет (0-15, 1 - наивысший)
+- биты 32-58: порядковый номер постановки (FIFO внутри класса,
+  счетчик 27 бит; перед переполнением куча перенумеровывает свои
+  элементы, см. PackedDaryHeap::renumber)
+- биты 0-31: индекс элемента в пуле
+Сравнение двух элементов - одно сравнение целых; ключ - одно машинное
+слово, его можно хранить в std::atomic и менять CAS
+ */
+struct PackedKey {
+    static const int sequence_bits = 27;
+    static const std::uint64_t sequence_mask = (std::uint64_t(1) << sequence_bits) - 1;
+    static const std::uint64_t class_mask = ~std::uint64_t(0) << 59;
+
+    // Класс элемента: критичность и приоритет (старшие 5 бит ключа)
+    static std::uint64_t make_class(bool is_critical, int priority) {
+        std::uint64_t level = static_cast<std::uint64_t>(priority < 0 ? 0 : priority > 15 ? 15 : priority);
+        return (static_cast<std::uint64_t>(!is_critical) << 63) | (level << 59);
+    }
+
+    static std::uint64_t make(std::uint64_t item_class, std::uint32_t sequence, std::uint32_t index) {
+        return item_class | ((sequence & sequence_mask) << 32) | index;
+    }
+
+    static bool is_critical(std::uint64_t key) { return (key >> 63) == 0; }
+    static int priority(std::uint64_t key) { return static_cast<int>((key >> 59) & 15); }
+    static std::uint64_t item_class(std::uint64_t key) { return key & class_mask; }
+    static std::uint32_t sequence(std::uint64_t key) { return static_cast<std::uint32_t>((key >> 32) & sequence_mask); }
+    static std::uint32_t index(std::uint64_t key) { return static_cast<std::uint32_t>(key); }
+};
+
+/*
+d-арная куча упакованных ключей
+- Элемент кучи - только 64-битный ключ, индекс полезной нагрузки
+  лежит в его младших битах, отдельного массива индексов нет
+- Полезная нагрузка хранится в пуле и не перемещается
+ */
+template <typename Payload, int Arity = 4>
+class PackedDaryHeap {
+    static_assert(Arity >= 2, "Arity должна быть не меньше 2");
+
+public:
+    void push(std::uint64_t item_class, const Payload& payload) {
+        std::uint32_t slot;
+        if (free_slots.empty()) {
+            slot = static_cast<std::uint32_t>(payloads.size());
+            payloads.push_back(payload);
+        } else {
+            slot = free_slots.back();
+            free_slots.pop_back();
+            payloads[slot] = payload;
+        }
+
+        if (next_sequence > PackedKey::sequence_mask) renumber();
+        keys.push_back(PackedKey::make(item_class, next_sequence++, slot));
+        sift_up(keys.size() - 1);
+    }
+
+    Payload pop() {
+        std::uint32_t slot = PackedKey::index(keys[0]);
+        Payload payload = payloads[slot];
+        free_slots.push_back(slot);
+
+        keys[0] = keys.back();
+        keys.pop_back();
+        if (!keys.empty()) sift_down(0);
+        return payload;
+    }
+
+    std::uint64_t top_key() const { return keys[0]; }
+    const Payload& top() const { return payloads[PackedKey::index(keys[0])]; }
+    bool empty() const { return keys.empty(); }
+    std::size_t size() const { return keys.size(); }
+
+    void reserve(std::size_t count) {
+        keys.reserve(count);
+        payloads.reserve(count);
+    }
+
+private:
+    /*
+    Счетчик номеров исчерпан: элементы получают номера 0..size-1 в порядке
+    своих ключей. Взаимный порядок ключей не меняется, поэтому свойство
+    кучи сохраняется, а новые элементы (номера от size) встают после
+    старых своего класса. O(n log n) раз в 2^27 добавлений; в куче должно
+    быть меньше 2^27 элементов
+     */
+    void renumber() {
+        std::vector<std::uint32_t> order(keys.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) { return keys[a] < keys[b]; });
+        for (std::size_t rank = 0; rank < order.size(); ++rank) {
+            std::uint64_t& key = keys[order[rank]];
+            key = PackedKey::make(PackedKey::item_class(key), static_cast<std::uint32_t>(rank), PackedKey::index(key));
+        }
+        next_sequence = static_cast<std::uint32_t>(keys.size());
+    }
+
+    void sift_up(std::size_t index) {
+        std::uint64_t key = keys[index];
+        while (index > 0) {
+            std::size_t parent = (index - 1) / Arity;
+            if (keys[parent] <= key) break;
+            keys[index] = keys[parent];
+            index = parent;
+        }
+        keys[index] = key;
+    }
+
+    void sift_down(std::size_t index) {
+        std::uint64_t key = keys[index];
+        std::size_t size = keys.size();
+        while (true) {
+            std::size_t first = index * Arity + 1;
+            if (first >= size) break;
+
+            std::size_t last = first + Arity < size ? first + Arity : size;
+            std::size_t best = first;
+            for (std::size_t child = first + 1; child < last; ++child) {
+                if (keys[child] < keys[best]) best = child;
+            }
+            if (key <= keys[best]) break;
+
+            keys[index] = keys[best];
+            index = best;
+        }
+        keys[index] = key;
+    }
+
+    std::vector<std::uint64_t> keys;       // Упакованные ключи в порядке кучи
+    std::vector<Payload> payloads;         // Пул полезной нагрузки
+    std::vector<std::uint32_t> free_slots; // Свободные ячейки пула
+    std::uint32_t next_sequence = 0;
+};
+
+/*
+Политика очереди диспетчера на упакованных ключах
+Item должен предоставлять queue_class() - PackedKey::make_class(...)
+ */
+template <typename Item, int Arity = 4>
+class PackedQueuePolicy {
+public:
+    void push(const Item& item) { heap.push(item.queue_class(), item); }
+    Item take() { return heap.pop(); }
+    bool empty() const { return heap.empty(); }
+    std::size_t size() const { return heap.size(); }
+
+private:
+    PackedDaryHeap<Item, Arity> heap;
+};
+
+#endif
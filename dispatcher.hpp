@@ -0,0 +1,278 @@
+#ifndef DISPATCHER_HPP
+#define DISPATCHER_HPP
+
+#include <queue>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <boost/thread.hpp>
+#include <boost/interprocess/sync/interprocess_semaphore.hpp>
+
+/*
+Политики очереди диспетчера
+Каждая политика предоставляет
+- push(item) - добавить элемент
+- take() - извлечь элемент с наивысшим приоритетом
+- empty(), size()
+Все вызовы выполняются под мьютексом диспетчера
+ */
+template <typename Item>
+class PriorityQueuePolicy {
+public:
+    void push(const Item& item) { queue.push(item); }
+
+    Item take() {
+        Item item = queue.top();
+        queue.pop();
+        return item;
+    }
+
+    bool empty() const { return queue.empty(); }
+    std::size_t size() const { return queue.size(); }
+
+private:
+    std::priority_queue<Item> queue;
+};
+
+template <typename Item>
+class FifoQueuePolicy {
+public:
+    void push(const Item& item) { queue.push_back(item); }
+
+    Item take() {
+        Item item = queue.front();
+        queue.pop_front();
+        return item;
+    }
+
+    bool empty() const { return queue.empty(); }
+    std::size_t size() const { return queue.size(); }
+
+private:
+    std::deque<Item> queue;
+};
+
+/*
+Кольцевой буфер фиксированной емкости
+Память - часть объекта, при push/take выделений нет (для потоков реального
+времени); переполнение проверяется через full() до push
+ */
+template <typename Item, std::size_t Capacity>
+class RingQueuePolicy {
+public:
+    void push(const Item& item) {
+        items[(head + count) % Capacity] = item;
+        ++count;
+    }
+
+    Item take() {
+        Item item = items[head];
+        head = (head + 1) % Capacity;
+        --count;
+        return item;
+    }
+
+    bool empty() const { return count == 0; }
+    bool full() const { return count == Capacity; }
+    std::size_t size() const { return count; }
+
+private:
+    Item items[Capacity];
+    std::size_t head = 0;
+    std::size_t count = 0;
+};
+
+/*
+Политики ожидания свободного потока
+- BlockingIdle - сразу засыпаем на условной переменной
+- SpinThenBlockIdle - несколько раз отпускаем мьютекс и уступаем
+  процессор, и только потом засыпаем
+- TunableSpinIdle - то же, но число попыток задается во время работы
+  (общее для всех диспетчеров с этой политикой, меняет автонастройка)
+ */
+struct BlockingIdle {
+    template <typename Lock, typename Ready>
+    static void wait(Lock& lock, boost::condition_variable& condition, Ready ready) {
+        while (!ready()) {
+            condition.wait(lock);
+        }
+    }
+};
+
+template <int SpinCount>
+struct SpinThenBlockIdle {
+    template <typename Lock, typename Ready>
+    static void wait(Lock& lock, boost::condition_variable& condition, Ready ready) {
+        for (int i = 0; i < SpinCount && !ready(); ++i) {
+            lock.unlock();
+            boost::this_thread::yield();
+            lock.lock();
+        }
+        while (!ready()) {
+            condition.wait(lock);
+        }
+    }
+};
+
+struct TunableSpinIdle {
+    static std::atomic<int>& spin_count() {
+        static std::atomic<int> count{0};
+        return count;
+    }
+
+    template <typename Lock, typename Ready>
+    static void wait(Lock& lock, boost::condition_variable& condition, Ready ready) {
+        int spins = spin_count().load(std::memory_order_relaxed);
+        for (int i = 0; i < spins && !ready(); ++i) {
+            lock.unlock();
+            boost::this_thread::yield();
+            lock.lock();
+        }
+        while (!ready()) {
+            condition.wait(lock);
+        }
+    }
+};
+
+/*
+Диспетчер: общая очередь + рабочие потоки + ограничение параллелизма
+Политики выбираются на этапе компиляции, виртуальных вызовов нет
+- Item - элемент очереди (задача, пакет данных)
+- QueuePolicy - порядок извлечения элементов
+- IdlePolicy - поведение потока при пустой очереди
+- ConcurrencyLimit - начальное число слотов семафора (0 - без ограничения)
+ */
+template <typename Item, typename QueuePolicy, typename IdlePolicy, int ConcurrencyLimit>
+class Dispatcher {
+public:
+    Dispatcher() : slots(ConcurrencyLimit > 0 ? ConcurrencyLimit : 0) {}
+
+    /*
+    Добавление элемента и пробуждение одного ожидающего потока
+     */
+    void push(const Item& item) {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        queue.push(item);
+        lock.unlock();
+        condition.notify_one();
+    }
+
+    /*
+    Добавление, если в очереди есть место (для политик с full())
+    Возвращает false, если очередь заполнена
+     */
+    bool try_push(const Item& item) {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (queue.full()) return false;
+        queue.push(item);
+        lock.unlock();
+        condition.notify_one();
+        return true;
+    }
+
+    /*
+    Извлечение элемента с наивысшим приоритетом
+    Возвращает false, если диспетчер остановлен
+     */
+    bool pop(Item& item) {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        IdlePolicy::wait(lock, condition, [this] { return !queue.empty() || shutdown; });
+        if (shutdown) return false;
+        item = queue.take();
+        return true;
+    }
+
+    /*
+    Извлечение до max_items элементов за один захват мьютекса
+    items очищается; false - диспетчер остановлен
+     */
+    bool pop_batch(std::vector<Item>& items, std::size_t max_items) {
+        items.clear();
+        boost::unique_lock<boost::mutex> lock(mutex);
+        IdlePolicy::wait(lock, condition, [this] { return !queue.empty() || shutdown; });
+        if (shutdown) return false;
+        while (items.size() < max_items && !queue.empty()) {
+            items.push_back(queue.take());
+        }
+        return true;
+    }
+
+    /*
+    То же с ограничением по стоимости: следующий элемент берется, пока
+    суммарная cost(item) взятых меньше budget (хотя бы один элемент)
+    Длинные элементы не копятся в пакете одного потока - иначе более
+    приоритетные, пришедшие позже, ждут весь пакет
+     */
+    template <typename Cost>
+    bool pop_batch(std::vector<Item>& items, std::size_t max_items, Cost cost, double budget) {
+        items.clear();
+        boost::unique_lock<boost::mutex> lock(mutex);
+        IdlePolicy::wait(lock, condition, [this] { return !queue.empty() || shutdown; });
+        if (shutdown) return false;
+        double total = 0.0;
+        while (items.size() < max_items && !queue.empty() && (items.empty() || total < budget)) {
+            items.push_back(queue.take());
+            total += cost(items.back());
+        }
+        return true;
+    }
+
+    /*
+    Захват и освобождение слота семафора
+     */
+    void acquire() {
+        if (ConcurrencyLimit > 0) slots.wait();
+    }
+
+    void release() {
+        if (ConcurrencyLimit > 0) slots.post();
+    }
+
+    // Захват без ожидания; false - свободных слотов нет
+    bool try_acquire() {
+        return ConcurrencyLimit == 0 || slots.try_wait();
+    }
+
+    /*
+    Запуск count рабочих потоков, каждый вызывает worker(i)
+     */
+    template <typename Worker>
+    void start(int count, Worker worker) {
+        for (int i = 0; i < count; ++i) {
+            threads.create_thread(boost::bind<void>(worker, i));
+        }
+    }
+
+    /*
+    Остановка: флаг завершения, пробуждение и ожидание всех потоков
+    Потоки, ждущие слот семафора до pop, получают по слоту и видят флаг
+     */
+    void stop() {
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            shutdown = true;
+        }
+        condition.notify_all();
+        if (ConcurrencyLimit > 0) {
+            for (std::size_t i = 0; i < threads.size(); ++i) slots.post();
+        }
+        threads.join_all();
+    }
+
+    bool stopping() const { return shutdown; }
+
+    std::size_t size() {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        return queue.size();
+    }
+
+private:
+    QueuePolicy queue;
+    boost::mutex mutex;
+    boost::condition_variable condition;
+    boost::interprocess::interprocess_semaphore slots;
+    boost::thread_group threads;
+    std::atomic<bool> shutdown{false};
+};
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef EPOCH_RECLAMATION_HPP
+#define EPOCH_RECLAMATION_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <boost/thread.hpp>
+
+/*
+Освобождение памяти по эпохам для структур без блокировок
+- Читатель входит в эпоху (EpochGuard) перед чтением общих указателей
+  и выходит после; вход и выход - две атомарные записи без блокировок
+- Снятый со структуры объект не удаляется сразу, а откладывается в список
+  потока с номером текущей глобальной эпохи (retire)
+- Глобальная эпоха растет, когда все активные потоки дошли до нее;
+  объект, отложенный в эпохе e, удаляется, когда глобальная эпоха >= e + 2 -
+  к этому моменту ни один читатель не может держать на него указатель
+- Отложенные объекты потока лежат в трех списках по эпохе (e mod 3):
+  удаление - проход по готовому списку целиком, без поиска
+- Мусор ограничен: при garbage_limit отложенных объектов поток пытается
+  сдвинуть эпоху и удалить старые объекты; при garbage_max (читатель
+  вытеснен внутри эпохи) retire вне эпохи ждет, пока мусор не освободится
+ */
+class EpochDomain {
+public:
+    static const int max_threads = 64;
+    static const std::size_t garbage_limit = 64;
+    static const std::size_t garbage_max = 4096;
+
+    EpochDomain() {
+        for (int slot = 0; slot < max_threads; ++slot) {
+            slots[slot].in_use.store(false);
+            slots[slot].state.store(0);
+        }
+    }
+
+    ~EpochDomain() {
+        // Участников больше нет, все отложенное можно удалить
+        for (const Retired& retired : orphans) retired.destroy(retired.object);
+    }
+
+    std::uint64_t epoch() const { return global_epoch.load(); }
+
+    // Счетчики
+    std::atomic<std::uint64_t> retired{0};   // Отложено объектов
+    std::atomic<std::uint64_t> freed{0};     // Удалено объектов
+    std::atomic<std::uint64_t> advances{0};  // Сдвигов глобальной эпохи
+
+private:
+    friend class EpochParticipant;
+
+    struct Retired {
+        void* object;
+        void (*destroy)(void*);
+        std::uint64_t epoch;
+    };
+
+    // Ячейка участника: state = (эпоха << 1) | активен
+    struct alignas(64) Slot {
+        std::atomic<bool> in_use;
+        std::atomic<std::uint64_t> state;
+    };
+
+    int attach() {
+        for (int slot = 0; slot < max_threads; ++slot) {
+            bool expected = false;
+            if (!slots[slot].in_use.load() && slots[slot].in_use.compare_exchange_strong(expected, true)) {
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+    /*
+    Сдвиг глобальной эпохи, если все активные участники в ней
+     */
+    bool try_advance() {
+        std::uint64_t current = global_epoch.load();
+        for (int slot = 0; slot < max_threads; ++slot) {
+            if (!slots[slot].in_use.load()) continue;
+            std::uint64_t state = slots[slot].state.load();
+            if ((state & 1) && (state >> 1) != current) return false;
+        }
+        if (global_epoch.compare_exchange_strong(current, current + 1)) advances++;
+        return true;
+    }
+
+    /*
+    Удаление объектов из list, отложенных не позже текущей эпохи - 2
+     */
+    void reclaim(std::vector<Retired>& list) {
+        std::uint64_t current = global_epoch.load();
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < list.size(); ++i) {
+            if (list[i].epoch + 2 <= current) {
+                list[i].destroy(list[i].object);
+            } else {
+                list[kept++] = list[i];
+            }
+        }
+        freed += list.size() - kept;
+        list.resize(kept);
+    }
+
+    // Удаление всего списка (все объекты списка из одной безопасной эпохи)
+    void free_all(std::vector<Retired>& list) {
+        for (const Retired& retired : list) retired.destroy(retired.object);
+        freed += list.size();
+        list.clear();
+    }
+
+    /*
+    Мусор ушедшего участника переходит в общий список домена
+     */
+    void adopt(std::vector<Retired>& list) {
+        boost::lock_guard<boost::mutex> lock(orphan_mutex);
+        orphans.insert(orphans.end(), list.begin(), list.end());
+        list.clear();
+        reclaim(orphans);
+    }
+
+    void reclaim_orphans() {
+        boost::unique_lock<boost::mutex> lock(orphan_mutex, boost::try_to_lock);
+        if (lock.owns_lock() && !orphans.empty()) reclaim(orphans);
+    }
+
+    std::atomic<std::uint64_t> global_epoch{2};
+    Slot slots[max_threads];
+    boost::mutex orphan_mutex;
+    std::vector<Retired> orphans;  // Мусор завершившихся участников
+};
+
+/*
+Участник домена - один на поток, живет не дольше домена
+Вызовы участника делает только его поток
+ */
+class EpochParticipant {
+public:
+    explicit EpochParticipant(EpochDomain& domain) : domain(domain), slot(domain.attach()) {
+        assert(slot >= 0 && "больше max_threads участников");
+        for (int bucket = 0; bucket < 3; ++bucket) {
+            limbo[bucket].reserve(EpochDomain::garbage_limit);
+            limbo_epoch[bucket] = 0;
+        }
+    }
+
+    ~EpochParticipant() {
+        collect();
+        for (int bucket = 0; bucket < 3; ++bucket) {
+            if (!limbo[bucket].empty()) domain.adopt(limbo[bucket]);
+        }
+        domain.slots[slot].state.store(0);
+        domain.slots[slot].in_use.store(false);
+    }
+
+    EpochParticipant(const EpochParticipant&) = delete;
+    EpochParticipant& operator=(const EpochParticipant&) = delete;
+
+    /*
+    Вход в эпоху и выход из нее (вложенность не поддерживается)
+     */
+    void enter() {
+        std::uint64_t epoch = domain.global_epoch.load(std::memory_order_relaxed);
+        domain.slots[slot].state.store((epoch << 1) | 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void exit() {
+        std::uint64_t state = domain.slots[slot].state.load(std::memory_order_relaxed);
+        domain.slots[slot].state.store(state & ~std::uint64_t(1), std::memory_order_release);
+    }
+
+    /*
+    Отложенное удаление объекта, уже снятого со структуры
+     */
+    template <typename T>
+    void retire(T* object) {
+        std::uint64_t epoch = domain.global_epoch.load();
+        int bucket = static_cast<int>(epoch % 3);
+        // В списке эпохи e - 3 или раньше: эти объекты уже безопасно удалить
+        if (limbo_epoch[bucket] != epoch) {
+            pending_count -= limbo[bucket].size();
+            domain.free_all(limbo[bucket]);
+            limbo_epoch[bucket] = epoch;
+        }
+        limbo[bucket].push_back(EpochDomain::Retired{object, &destroy<T>, epoch});
+        domain.retired++;
+        if (++pending_count >= EpochDomain::garbage_limit) collect();
+
+        // Вне эпохи ждем читателей, иначе (внутри эпохи) ждать нельзя - сами держим эпоху
+        bool inside = (domain.slots[slot].state.load(std::memory_order_relaxed) & 1) != 0;
+        while (!inside && pending_count >= EpochDomain::garbage_max) {
+            boost::this_thread::yield();
+            collect();
+        }
+    }
+
+    /*
+    Попытка сдвинуть эпоху и удалить то, что уже безопасно
+    Вызывается в конце итерации рабочего цикла, вне эпохи
+     */
+    void collect() {
+        domain.try_advance();
+        std::uint64_t current = domain.global_epoch.load();
+        for (int bucket = 0; bucket < 3; ++bucket) {
+            if (!limbo[bucket].empty() && limbo_epoch[bucket] + 2 <= current) {
+                pending_count -= limbo[bucket].size();
+                domain.free_all(limbo[bucket]);
+            }
+        }
+        domain.reclaim_orphans();
+    }
+
+    std::size_t pending() const { return pending_count; }
+
+private:
+    template <typename T>
+    static void destroy(void* object) { delete static_cast<T*>(object); }
+
+    EpochDomain& domain;
+    int slot;
+    std::vector<EpochDomain::Retired> limbo[3];  // Отложенные объекты потока по эпохе mod 3
+    std::uint64_t limbo_epoch[3];                // Эпоха объектов каждого списка
+    std::size_t pending_count = 0;
+};
+
+/*
+Эпоха на время области видимости
+ */
+class EpochGuard {
+public:
+    explicit EpochGuard(EpochParticipant& participant) : participant(participant) { participant.enter(); }
+    ~EpochGuard() { participant.exit(); }
+
+private:
+    EpochParticipant& participant;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef FORECASTER_HPP
+#define FORECASTER_HPP
+
+/*
+Краткосрочный прогноз интенсивности поступлений (метод Хольта:
+экспоненциальное сглаживание уровня и тренда)
+- observe(value) - число поступлений за очередной интервал
+- forecast(steps) - ожидаемое значение через steps интервалов
+ */
+class ArrivalForecaster {
+public:
+    ArrivalForecaster(double alpha, double beta) : alpha(alpha), beta(beta) {}
+
+    void observe(double value) {
+        if (samples == 0) {
+            level = value;
+            trend = 0.0;
+        } else {
+            double previous = level;
+            level = alpha * value + (1.0 - alpha) * (level + trend);
+            trend = beta * (level - previous) + (1.0 - beta) * trend;
+        }
+        ++samples;
+    }
+
+    double forecast(double steps) const {
+        double value = level + steps * trend;
+        return value > 0.0 ? value : 0.0;
+    }
+
+    // Прогноз осмысленен после двух наблюдений (есть оценка тренда)
+    bool ready() const { return samples >= 2; }
+
+private:
+    double alpha;       // Вес нового наблюдения в уровне
+    double beta;        // Вес нового изменения в тренде
+    double level = 0.0;
+    double trend = 0.0;
+    int samples = 0;
+};
+
+#endif
@@ -0,0 +1,373 @@
+#ifndef GRID_DES_HPP
+#define GRID_DES_HPP
+
+#include <vector>
+#include <queue>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <boost/thread.hpp>
+#include "calendar_queue.hpp"
+
+/*
+Параметры модели энергосети в виртуальном времени
+- Станции отправляют пакеты с экспоненциальными интервалами (как station_thread)
+- Региональные серверы обрабатывают пакеты за 100-500 мс (как server_handler)
+- При переполнении очереди региона пакет пересылается в соседний регион
+  с задержкой канала link_delay
+ */
+struct GridConfig {
+    int stations = 10000;
+    int regions = 2000;
+    int handlers = 2;           // Обработчиков в каждом регионе
+    int queue_limit = 20;       // Длина очереди, после которой пакет пересылается
+    int max_hops = 3;           // Пересылок до отбрасывания пакета
+    double link_delay = 0.05;   // Задержка канала между регионами, с
+    double duration = 60.0;     // Длительность моделирования, с
+    std::uint64_t seed = 1;
+};
+
+/*
+Итоги моделирования
+ */
+struct GridStats {
+    std::uint64_t events = 0;
+    std::uint64_t received = 0;
+    std::uint64_t processed = 0;
+    std::uint64_t forwarded = 0;
+    std::uint64_t dropped = 0;
+    double wait_sum = 0.0;      // Суммарное ожидание в очередях, с
+    std::size_t max_queue = 0;
+
+    void merge(const GridStats& other) {
+        events += other.events;
+        received += other.received;
+        processed += other.processed;
+        forwarded += other.forwarded;
+        dropped += other.dropped;
+        wait_sum += other.wait_sum;
+        if (other.max_queue > max_queue) max_queue = other.max_queue;
+    }
+
+    bool operator==(const GridStats& other) const {
+        return events == other.events && received == other.received &&
+               processed == other.processed && forwarded == other.forwarded &&
+               dropped == other.dropped && wait_sum == other.wait_sum &&
+               max_queue == other.max_queue;
+    }
+};
+
+/*
+Детерминированный генератор: значение зависит только от (seed, a, b),
+а не от порядка обработки событий
+ */
+inline double grid_uniform(std::uint64_t seed, std::uint64_t a, std::uint64_t b) {
+    std::uint64_t z = seed + a * 0x9E3779B97F4A7C15ULL + b * 0xD1B54A32D192ED03ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+Дискретно-событийная модель энергосети
+EventList - список событий (CalendarQueue или BinaryHeapEventList)
+Модель может владеть частью регионов [first_region, last_region) и их
+станциями (логический процесс параллельного прогона); пересылки в чужие
+регионы складываются в outbox
+ */
+template <template <typename> class EventList>
+class GridSimulator {
+public:
+    struct Packet {
+        int station;
+        std::uint32_t number;   // Порядковый номер пакета станции
+        int priority;
+        bool is_critical;
+        int hops;
+        double arrival;         // Время поступления в очередь региона
+
+        // Тот же порядок, что и у DataPacket; равные - по станции и номеру
+        bool operator<(const Packet& other) const {
+            if (is_critical != other.is_critical) return !is_critical;
+            if (priority != other.priority) return priority > other.priority;
+            if (station != other.station) return station > other.station;
+            return number > other.number;
+        }
+    };
+
+    struct Event {
+        int target;             // Станция или регион
+        Packet packet;
+    };
+
+    typedef typename EventList<Event>::Entry Entry;
+
+    explicit GridSimulator(const GridConfig& config) :
+        GridSimulator(config, 0, config.regions) {}
+
+    GridSimulator(const GridConfig& config, int first_region, int last_region) :
+        config(config),
+        first_region(first_region),
+        last_region(last_region),
+        first_station(first_station_of(first_region)),
+        sent(first_station_of(last_region) - first_station, 0),
+        regions(last_region - first_region)
+    {
+        // Первая отправка каждой станции
+        for (int station = first_station; station < first_station_of(last_region); ++station) {
+            schedule_send(station, 0.0);
+        }
+    }
+
+    /*
+    Обработка событий до конца интервала моделирования
+     */
+    void run() {
+        run_until(config.duration);
+    }
+
+    /*
+    Обработка событий с временем меньше end
+     */
+    void run_until(double end) {
+        if (end > config.duration) end = config.duration;
+        while (!events.empty()) {
+            Entry entry = events.pop();
+            if (entry.time >= end) {
+                events.push(entry.time, entry.tag, entry.event);
+                break;
+            }
+            ++totals.events;
+            dispatch(entry.time, entry.tag, entry.event);
+        }
+    }
+
+    /*
+    Прием пересылки из другого логического процесса
+     */
+    void deliver(const Entry& entry) {
+        events.push(entry.time, entry.tag, entry.event);
+    }
+
+    bool owns(int region_id) const {
+        return region_id >= first_region && region_id < last_region;
+    }
+
+    // Пересылки в регионы других логических процессов
+    std::vector<Entry> outbox;
+
+    GridStats stats() const {
+        GridStats result;
+        accumulate(result);
+        return result;
+    }
+
+    /*
+    Добавление итогов к result в порядке регионов, чтобы суммы
+    с плавающей точкой не зависели от разбиения
+     */
+    void accumulate(GridStats& result) const {
+        result.events += totals.events;
+        for (const Region& region : regions) {
+            result.merge(region.stats);
+        }
+    }
+
+private:
+    // Виды событий, старшие биты ключа tag
+    enum EventKind : std::uint64_t { STATION_SEND = 0, HANDLER_DONE = 1, FORWARD_ARRIVAL = 2 };
+
+    struct Region {
+        std::priority_queue<Packet> queue;
+        int busy = 0;
+        std::uint32_t services = 0;
+        GridStats stats;
+    };
+
+    static std::uint64_t make_tag(EventKind kind, std::uint64_t entity, std::uint64_t counter) {
+        return (kind << 62) | (entity << 32) | counter;
+    }
+
+    int region_of(int station) const {
+        return static_cast<int>(static_cast<std::int64_t>(station) * config.regions / config.stations);
+    }
+
+    // Первая станция региона: наименьшая s, для которой region_of(s) >= region_id
+    int first_station_of(int region_id) const {
+        std::int64_t total = static_cast<std::int64_t>(region_id) * config.stations;
+        return static_cast<int>((total + config.regions - 1) / config.regions);
+    }
+
+    Region& region_at(int region_id) { return regions[region_id - first_region]; }
+    std::uint32_t& sent_by(int station) { return sent[station - first_station]; }
+
+    void schedule_send(int station, double now) {
+        std::uint32_t number = sent_by(station);
+        double u = grid_uniform(config.seed, station, 3 * static_cast<std::uint64_t>(number));
+        double time = now - std::log(1.0 - u);  // Экспоненциальный интервал, среднее 1 с
+        events.push(time, make_tag(STATION_SEND, station, number), Event{station, Packet()});
+    }
+
+    void dispatch(double now, std::uint64_t tag, const Event& event) {
+        switch (tag >> 62) {
+        case STATION_SEND:    on_send(now, event.target); break;
+        case HANDLER_DONE:    on_done(now, event.target); break;
+        case FORWARD_ARRIVAL: on_arrival(now, event.target, event.packet); break;
+        }
+    }
+
+    /*
+    Станция формирует пакет и планирует следующую отправку
+     */
+    void on_send(double now, int station) {
+        std::uint32_t number = sent_by(station)++;
+        std::uint64_t draw = 3 * static_cast<std::uint64_t>(number);
+        Packet packet;
+        packet.station = station;
+        packet.number = number;
+        packet.priority = 1 + static_cast<int>(grid_uniform(config.seed, station, draw + 1) * 5); // Приоритеты 1-5
+        packet.is_critical = grid_uniform(config.seed, station, draw + 2) < 0.15; // 15% критических данных
+        packet.hops = 0;
+        schedule_send(station, now);
+        on_arrival(now, region_of(station), packet);
+    }
+
+    /*
+    Пакет поступает в регион: сразу на свободный обработчик, в очередь
+    или, если очередь переполнена, в соседний регион
+     */
+    void on_arrival(double now, int region_id, Packet packet) {
+        Region& region = region_at(region_id);
+        ++region.stats.received;
+        packet.arrival = now;
+
+        if (region.busy < config.handlers) {
+            ++region.busy;
+            start_service(now, region_id);
+        } else if (static_cast<int>(region.queue.size()) < config.queue_limit) {
+            region.queue.push(packet);
+            if (region.queue.size() > region.stats.max_queue) region.stats.max_queue = region.queue.size();
+        } else if (packet.hops < config.max_hops) {
+            ++region.stats.forwarded;
+            ++packet.hops;
+            int next = (region_id + 1) % config.regions;
+            Entry entry{now + config.link_delay,
+                        make_tag(FORWARD_ARRIVAL, packet.station, packet.number),
+                        Event{next, packet}};
+            if (owns(next)) {
+                deliver(entry);
+            } else {
+                outbox.push_back(entry);
+            }
+        } else {
+            ++region.stats.dropped;
+        }
+    }
+
+    void start_service(double now, int region_id) {
+        Region& region = region_at(region_id);
+        std::uint32_t service = region.services++;
+        double u = grid_uniform(config.seed ^ 0x5EA5ULL, region_id, service);
+        double time = now + 0.1 + 0.4 * u;  // Обработка 100-500 мс
+        events.push(time, make_tag(HANDLER_DONE, region_id, service), Event{region_id, Packet()});
+    }
+
+    /*
+    Обработчик освободился: берет следующий пакет или простаивает
+     */
+    void on_done(double now, int region_id) {
+        Region& region = region_at(region_id);
+        ++region.stats.processed;
+        if (region.queue.empty()) {
+            --region.busy;
+            return;
+        }
+        region.stats.wait_sum += now - region.queue.top().arrival;
+        region.queue.pop();
+        start_service(now, region_id);
+    }
+
+    GridConfig config;
+    int first_region;
+    int last_region;
+    int first_station;
+    EventList<Event> events;
+    std::vector<std::uint32_t> sent;  // Число отправок каждой станции
+    std::vector<Region> regions;
+    GridStats totals;                 // Только число событий
+};
+
+/*
+Консервативный параллельный прогон модели
+- Регионы делятся на непрерывные блоки, блок - логический процесс в своем потоке
+- Единственное взаимодействие блоков - пересылка пакета с задержкой link_delay,
+  поэтому она же служит упреждением (lookahead): события окна
+  [T, T + link_delay) не зависят от чужих событий того же окна
+- После каждого окна потоки обмениваются пересылками на барьере
+Порядок (time, tag) и детерминированный генератор дают те же итоги,
+что и последовательный прогон
+ */
+template <template <typename> class EventList>
+class ParallelGridSimulator {
+public:
+    typedef GridSimulator<EventList> Process;
+
+    ParallelGridSimulator(const GridConfig& config, int process_count) :
+        config(config),
+        barrier(static_cast<unsigned>(std::max(1, std::min(process_count, config.regions))))
+    {
+        int count = std::max(1, std::min(process_count, config.regions));
+        for (int i = 0; i < count; ++i) {
+            int first = static_cast<int>(static_cast<std::int64_t>(i) * config.regions / count);
+            int last = static_cast<int>(static_cast<std::int64_t>(i + 1) * config.regions / count);
+            processes.emplace_back(new Process(config, first, last));
+        }
+    }
+
+    void run() {
+        boost::thread_group threads;
+        for (std::size_t i = 0; i < processes.size(); ++i) {
+            threads.create_thread(boost::bind(&ParallelGridSimulator::process_thread, this, i));
+        }
+        threads.join_all();
+    }
+
+    GridStats stats() const {
+        GridStats result;
+        for (const std::unique_ptr<Process>& process : processes) {
+            process->accumulate(result);
+        }
+        return result;
+    }
+
+private:
+    /*
+    Поток логического процесса: окно событий, барьер,
+    прием пересылок, барьер, очистка своего outbox
+     */
+    void process_thread(std::size_t index) {
+        Process& self = *processes[index];
+        for (double window_end = config.link_delay; ; window_end += config.link_delay) {
+            self.run_until(window_end);
+            barrier.wait();
+
+            for (const std::unique_ptr<Process>& other : processes) {
+                for (const typename Process::Entry& entry : other->outbox) {
+                    if (self.owns(entry.event.target)) self.deliver(entry);
+                }
+            }
+            barrier.wait();
+
+            self.outbox.clear();
+            if (window_end >= config.duration) break;
+        }
+    }
+
+    GridConfig config;
+    std::vector<std::unique_ptr<Process>> processes;
+    boost::barrier barrier;
+};
+
+#endif
@@ -0,0 +1,297 @@
+#ifndef HARMONICS_HPP
+#define HARMONICS_HPP
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <boost/thread.hpp>
+#include "tsc_clock.hpp"
+
+/*
+План вещественного БПФ для блоков длины size (степень двойки)
+- Вещественный блок из size отсчетов упаковывается в комплексный
+  длины size/2, после БПФ спектр распаковывается (k = 0..size/2)
+- Поворотные множители и перестановка индексов вычисляются один раз
+- Пачка блоков хранится "по отсчетам": элемент n блока b лежит в [n * batch + b],
+  поэтому во всех бабочках внутренний цикл идет по блокам пачки подряд
+  и векторизуется компилятором (SIMD по блокам)
+- Планы кэшируются по длине блока, план неизменяем и общий для потоков
+ */
+class RealFftPlan {
+public:
+    explicit RealFftPlan(int size) :
+        block_size(size),
+        half(size / 2),
+        reversed(size / 2),
+        cos_table(size / 4 > 0 ? size / 4 : 1),
+        sin_table(size / 4 > 0 ? size / 4 : 1),
+        post_cos(size / 2 + 1),
+        post_sin(size / 2 + 1)
+    {
+        const double pi = 3.14159265358979323846;
+        int bits = 0;
+        while ((1 << bits) < half) ++bits;
+        for (int m = 0; m < half; ++m) {
+            int r = 0;
+            for (int bit = 0; bit < bits; ++bit) {
+                if (m & (1 << bit)) r |= 1 << (bits - 1 - bit);
+            }
+            reversed[m] = r;
+        }
+        // Множители комплексного БПФ длины half: W^j = exp(-2 pi i j / half)
+        for (int j = 0; j < half / 2; ++j) {
+            cos_table[j] = static_cast<float>(std::cos(2 * pi * j / half));
+            sin_table[j] = static_cast<float>(-std::sin(2 * pi * j / half));
+        }
+        // Множители распаковки: exp(-2 pi i k / size)
+        for (int k = 0; k <= half; ++k) {
+            post_cos[k] = static_cast<float>(std::cos(2 * pi * k / size));
+            post_sin[k] = static_cast<float>(-std::sin(2 * pi * k / size));
+        }
+    }
+
+    int size() const { return block_size; }
+
+    /*
+    Общий план для длины блока size
+     */
+    static const RealFftPlan& get(int size) {
+        static boost::mutex mutex;
+        static std::map<int, std::unique_ptr<RealFftPlan>> plans;
+        boost::lock_guard<boost::mutex> lock(mutex);
+        std::unique_ptr<RealFftPlan>& plan = plans[size];
+        if (!plan) plan.reset(new RealFftPlan(size));
+        return *plan;
+    }
+
+    /*
+    Спектр пачки из batch блоков
+    input[b * size + n] - отсчеты блоков
+    out_re/out_im[k * batch + b], k = 0..size/2 - спектр
+    work_re/work_im - рабочие буферы вызывающего, не меньше size/2 * batch
+     */
+    void execute(const float* input, int batch, float* work_re, float* work_im,
+                 float* out_re, float* out_im) const {
+        // Упаковка: z[m] = x[2m] + i x[2m+1], с перестановкой индексов
+        for (int b = 0; b < batch; ++b) {
+            const float* block = input + static_cast<std::size_t>(b) * block_size;
+            for (int m = 0; m < half; ++m) {
+                std::size_t cell = static_cast<std::size_t>(reversed[m]) * batch + b;
+                work_re[cell] = block[2 * m];
+                work_im[cell] = block[2 * m + 1];
+            }
+        }
+
+        // Бабочки по уровням, внутренний цикл по блокам пачки
+        for (int length = 2; length <= half; length *= 2) {
+            int step = half / length;
+            for (int start = 0; start < half; start += length) {
+                for (int j = 0; j < length / 2; ++j) {
+                    float wr = cos_table[j * step];
+                    float wi = sin_table[j * step];
+                    float* ur = work_re + static_cast<std::size_t>(start + j) * batch;
+                    float* ui = work_im + static_cast<std::size_t>(start + j) * batch;
+                    float* vr = work_re + static_cast<std::size_t>(start + j + length / 2) * batch;
+                    float* vi = work_im + static_cast<std::size_t>(start + j + length / 2) * batch;
+                    for (int b = 0; b < batch; ++b) {
+                        float tr = vr[b] * wr - vi[b] * wi;
+                        float ti = vr[b] * wi + vi[b] * wr;
+                        vr[b] = ur[b] - tr;
+                        vi[b] = ui[b] - ti;
+                        ur[b] += tr;
+                        ui[b] += ti;
+                    }
+                }
+            }
+        }
+
+        // Распаковка спектра вещественного сигнала
+        for (int k = 0; k <= half; ++k) {
+            const float* zr = work_re + static_cast<std::size_t>(k % half) * batch;
+            const float* zi = work_im + static_cast<std::size_t>(k % half) * batch;
+            const float* cr = work_re + static_cast<std::size_t>((half - k) % half) * batch;
+            const float* ci = work_im + static_cast<std::size_t>((half - k) % half) * batch;
+            float wr = post_cos[k];
+            float wi = post_sin[k];
+            float* xr = out_re + static_cast<std::size_t>(k) * batch;
+            float* xi = out_im + static_cast<std::size_t>(k) * batch;
+            for (int b = 0; b < batch; ++b) {
+                float er = 0.5f * (zr[b] + cr[b]);
+                float ei = 0.5f * (zi[b] - ci[b]);
+                float odd_r = 0.5f * (zi[b] + ci[b]);
+                float odd_i = -0.5f * (zr[b] - cr[b]);
+                xr[b] = er + wr * odd_r - wi * odd_i;
+                xi[b] = ei + wr * odd_i + wi * odd_r;
+            }
+        }
+    }
+
+private:
+    int block_size;
+    int half;
+    std::vector<int> reversed;     // Перестановка индексов комплексного БПФ
+    std::vector<float> cos_table;  // Множители комплексного БПФ
+    std::vector<float> sin_table;
+    std::vector<float> post_cos;   // Множители распаковки
+    std::vector<float> post_sin;
+};
+
+/*
+Пул блоков отсчетов фиксированного размера
+Пакет хранит номер блока, а не сами отсчеты, поэтому остается
+маленьким при перемещениях в очереди
+Свободные блоки - стек без блокировок (номер вершины + счетчик против
+ABA в одном 64-битном слове): блоки освобождает и поток реального
+времени, мьютекс, общий с обычными потоками, дал бы инверсию приоритетов
+ */
+class SampleBlockPool {
+public:
+    SampleBlockPool(int blocks, int block_size) :
+        block_size(block_size),
+        samples(static_cast<std::size_t>(blocks) * block_size),
+        next(blocks)
+    {
+        for (int block = 0; block < blocks; ++block) {
+            next[block].store(block + 1 < blocks ? block + 1 : -1);
+        }
+        head.store(pack(0, blocks > 0 ? 0 : -1));
+    }
+
+    /*
+    Свободный блок или -1, если пул исчерпан
+     */
+    int acquire() {
+        std::uint64_t top = head.load();
+        while (true) {
+            int block = index_of(top);
+            if (block < 0) return -1;
+            std::uint64_t replacement = pack(tag_of(top) + 1, next[block].load());
+            if (head.compare_exchange_weak(top, replacement)) return block;
+        }
+    }
+
+    void release(int block) {
+        if (block < 0) return;
+        std::uint64_t top = head.load();
+        while (true) {
+            next[block].store(index_of(top));
+            if (head.compare_exchange_weak(top, pack(tag_of(top) + 1, block))) return;
+        }
+    }
+
+    float* data(int block) { return &samples[static_cast<std::size_t>(block) * block_size]; }
+    int size() const { return block_size; }
+
+private:
+    static std::uint64_t pack(std::uint32_t tag, int block) {
+        return (static_cast<std::uint64_t>(tag) << 32) | static_cast<std::uint32_t>(block);
+    }
+    static std::uint32_t tag_of(std::uint64_t word) { return static_cast<std::uint32_t>(word >> 32); }
+    static int index_of(std::uint64_t word) { return static_cast<int>(static_cast<std::uint32_t>(word)); }
+
+    int block_size;
+    std::vector<float> samples;
+    std::vector<std::atomic<int>> next;   // Следующий свободный блок, -1 - конец
+    std::atomic<std::uint64_t> head;      // (счетчик << 32) | вершина стека
+};
+
+/*
+Гармонический состав блока одной станции
+ */
+struct HarmonicResult {
+    int station;
+    double thd;                        // Коэффициент гармоник, доля основной
+    const float* magnitudes;           // Амплитуды гармоник 1..harmonics, [h - 1]
+    int harmonics;
+};
+
+/*
+Этап гармонического анализа
+- Блоки разных станций копируются в пачку; полная пачка обрабатывается
+  одним вызовом БПФ по плану для длины блока
+- Блок содержит cycles целых периодов основной частоты, поэтому гармоника h
+  лежит в бине h * cycles; бинов block_size/2 + 1, поэтому
+  harmonics * cycles > block_size/2 отвергается (std::invalid_argument)
+ */
+class HarmonicStage {
+public:
+    typedef std::function<void(const HarmonicResult&)> Sink;
+
+    HarmonicStage(int block_size, int cycles, int batch, int harmonics, Sink sink) :
+        plan(RealFftPlan::get(block_size)),
+        cycles(cycles),
+        batch(batch),
+        harmonics(harmonics),
+        sink(sink),
+        input(static_cast<std::size_t>(batch) * block_size),
+        stations(batch),
+        work_re(static_cast<std::size_t>(batch) * block_size / 2),
+        work_im(static_cast<std::size_t>(batch) * block_size / 2),
+        spectrum_re(static_cast<std::size_t>(batch) * (block_size / 2 + 1)),
+        spectrum_im(static_cast<std::size_t>(batch) * (block_size / 2 + 1)),
+        magnitudes(harmonics)
+    {
+        if (cycles < 1 || harmonics < 1 || harmonics * cycles > block_size / 2) {
+            throw std::invalid_argument("HarmonicStage: гармоники за пределами спектра блока");
+        }
+    }
+
+    void add(int station, const float* samples) {
+        std::copy(samples, samples + plan.size(), &input[static_cast<std::size_t>(pending) * plan.size()]);
+        stations[pending] = station;
+        if (++pending == batch) flush();
+    }
+
+    /*
+    Обработка накопленной (возможно неполной) пачки
+     */
+    void flush() {
+        if (pending == 0) return;
+        std::uint64_t begin = TscClock::now();
+        plan.execute(input.data(), pending, work_re.data(), work_im.data(),
+                     spectrum_re.data(), spectrum_im.data());
+
+        for (int b = 0; b < pending; ++b) {
+            double harmonic_power = 0.0;
+            for (int h = 1; h <= harmonics; ++h) {
+                std::size_t cell = static_cast<std::size_t>(h * cycles) * pending + b;
+                float magnitude = 2.0f * std::sqrt(spectrum_re[cell] * spectrum_re[cell] +
+                                                   spectrum_im[cell] * spectrum_im[cell]) / plan.size();
+                magnitudes[h - 1] = magnitude;
+                if (h > 1) harmonic_power += static_cast<double>(magnitude) * magnitude;
+            }
+            double thd = magnitudes[0] > 0 ? std::sqrt(harmonic_power) / magnitudes[0] : 0.0;
+            if (sink) sink(HarmonicResult{stations[b], thd, magnitudes.data(), harmonics});
+        }
+
+        blocks += pending;
+        busy_ticks += TscClock::now() - begin;
+        pending = 0;
+    }
+
+    // Счетчики
+    std::uint64_t blocks = 0;      // Обработано блоков
+    std::uint64_t busy_ticks = 0;  // Время БПФ и анализа, тики TscClock
+
+private:
+    const RealFftPlan& plan;
+    int cycles;
+    int batch;
+    int harmonics;
+    Sink sink;
+    int pending = 0;
+    std::vector<float> input;      // batch x block_size
+    std::vector<int> stations;
+    std::vector<float> work_re;
+    std::vector<float> work_im;
+    std::vector<float> spectrum_re;
+    std::vector<float> spectrum_im;
+    std::vector<float> magnitudes;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <cstdint>
+
+/*
+Логарифмическая гистограмма задержек (значения в мкс)
+- 16 корзин на каждую степень двойки, относительная погрешность ~6%
+- Запись - несколько битовых операций и один атомарный инкремент,
+  писать можно из нескольких потоков
+ */
+class LatencyHistogram {
+public:
+    void record(std::uint64_t value) {
+        buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t current = maximum.load(std::memory_order_relaxed);
+        while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    /*
+    Значение, не меньше которого доля fraction записей (0.99 - p99)
+    Возвращается верхняя граница корзины
+     */
+    std::uint64_t percentile(double fraction) const {
+        std::uint64_t count = total.load(std::memory_order_relaxed);
+        if (count == 0) return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(fraction * count);
+        if (rank >= count) rank = count - 1;
+        std::uint64_t seen = 0;
+        for (int bucket = 0; bucket < bucket_count; ++bucket) {
+            seen += buckets[bucket].load(std::memory_order_relaxed);
+            if (seen > rank) {
+                std::uint64_t upper = upper_bound(bucket);
+                std::uint64_t top = max();
+                return upper < top ? upper : top;
+            }
+        }
+        return max();
+    }
+
+    std::uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    std::uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+
+    void reset() {
+        for (int bucket = 0; bucket < bucket_count; ++bucket) buckets[bucket].store(0);
+        total.store(0);
+        maximum.store(0);
+    }
+
+private:
+    static const int sub_bits = 4;
+    static const int bucket_count = (64 - sub_bits + 1) << sub_bits;
+
+    // Значения меньше 16 - по корзине на значение, дальше 16 корзин на октаву
+    static int bucket_of(std::uint64_t value) {
+        if (value < (1u << sub_bits)) return static_cast<int>(value);
+        int exponent = 63 - __builtin_clzll(value);
+        int shift = exponent - sub_bits;
+        int sub = static_cast<int>((value >> shift) & ((1u << sub_bits) - 1));
+        return ((shift + 1) << sub_bits) + sub;
+    }
+
+    static std::uint64_t upper_bound(int bucket) {
+        if (bucket < (1 << sub_bits)) return static_cast<std::uint64_t>(bucket);
+        int shift = (bucket >> sub_bits) - 1;
+        std::uint64_t sub = static_cast<std::uint64_t>(bucket & ((1 << sub_bits) - 1));
+        return (((std::uint64_t(1) << sub_bits) + sub + 1) << shift) - 1;
+    }
+
+    std::atomic<std::uint64_t> buckets[bucket_count] = {};
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> maximum{0};
+};
+
+#endif
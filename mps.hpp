@@ -0,0 +1,471 @@
+#ifndef MPS_HPP
+#define MPS_HPP
+
+#include <vector>
+#include <limits>
+#include <array>
+#include <complex>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include "circuit.hpp"
+#include "pauli.hpp"
+
+/*
+Сингулярное разложение a = u * diag(s) * vt комплексной матрицы
+rows x cols (по строкам) односторонним методом Якоби
+- Столбцы попарно вращаются, пока не станут ортогональными; нормы
+  столбцов - сингулярные числа, накопленные вращения - v
+- При cols > rows разлагается сопряженная матрица
+- u: rows x k, vt: k x cols, k = min(rows, cols), s по убыванию
+ */
+inline void jacobi_svd(const std::vector<std::complex<double>>& a, int rows, int cols,
+                       std::vector<std::complex<double>>& u, std::vector<double>& s,
+                       std::vector<std::complex<double>>& vt) {
+    typedef std::complex<double> C;
+    const bool transposed = cols > rows;
+    const int m = transposed ? cols : rows;  // Длина столбца
+    const int n = transposed ? rows : cols;  // Число столбцов
+
+    // w - столбцы по порядку (столбец j: w[j * m .. j * m + m))
+    std::vector<C> w(static_cast<std::size_t>(m) * n);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            C value = a[static_cast<std::size_t>(i) * cols + j];
+            if (transposed) w[static_cast<std::size_t>(i) * m + j] = std::conj(value);
+            else w[static_cast<std::size_t>(j) * m + i] = value;
+        }
+    }
+    std::vector<C> v(static_cast<std::size_t>(n) * n, C(0.0, 0.0));
+    for (int j = 0; j < n; ++j) v[static_cast<std::size_t>(j) * n + j] = C(1.0, 0.0);
+
+    // Квадраты норм столбцов, обновляются при вращении без пересчета
+    std::vector<double> squares(n, 0.0);
+    for (int j = 0; j < n; ++j) {
+        for (int k = 0; k < m; ++k) squares[j] += std::norm(w[static_cast<std::size_t>(j) * m + k]);
+    }
+
+    const double eps = 1e-15;
+    for (int sweep = 0; sweep < 60; ++sweep) {
+        bool rotated = false;
+        for (int i = 0; i + 1 < n; ++i) {
+            for (int j = i + 1; j < n; ++j) {
+                C* ci = &w[static_cast<std::size_t>(i) * m];
+                C* cj = &w[static_cast<std::size_t>(j) * m];
+                double alpha = squares[i], beta = squares[j];
+                C gamma(0.0, 0.0);
+                for (int k = 0; k < m; ++k) gamma += std::conj(ci[k]) * cj[k];
+                double g = std::abs(gamma);
+                if (g <= eps * std::sqrt(alpha * beta) || g == 0.0) continue;
+                rotated = true;
+
+                // Фаза переносится на столбец j, дальше вращение вещественное
+                C phase = std::conj(gamma) / g;
+                double zeta = (beta - alpha) / (2.0 * g);
+                double t = (zeta >= 0 ? 1.0 : -1.0) / (std::fabs(zeta) + std::sqrt(1.0 + zeta * zeta));
+                double c = 1.0 / std::sqrt(1.0 + t * t);
+                double sn = c * t;
+                squares[i] = alpha - t * g;
+                squares[j] = beta + t * g;
+                for (int k = 0; k < m; ++k) {
+                    C x = ci[k], y = cj[k] * phase;
+                    ci[k] = c * x - sn * y;
+                    cj[k] = sn * x + c * y;
+                }
+                C* vi = &v[static_cast<std::size_t>(i) * n];
+                C* vj = &v[static_cast<std::size_t>(j) * n];
+                for (int k = 0; k < n; ++k) {
+                    C x = vi[k], y = vj[k] * phase;
+                    vi[k] = c * x - sn * y;
+                    vj[k] = sn * x + c * y;
+                }
+            }
+        }
+        if (!rotated) break;
+    }
+
+    // Сингулярные числа по убыванию
+    std::vector<double> norms(n);
+    std::vector<int> order(n);
+    for (int j = 0; j < n; ++j) {
+        double sum = 0.0;
+        for (int k = 0; k < m; ++k) sum += std::norm(w[static_cast<std::size_t>(j) * m + k]);
+        norms[j] = std::sqrt(sum);
+        order[j] = j;
+    }
+    std::sort(order.begin(), order.end(), [&norms](int x, int y) { return norms[x] > norms[y]; });
+
+    // w * v = u' s: для a - u = u', vt = v^H; для a^H - наоборот
+    s.resize(n);
+    u.assign(static_cast<std::size_t>(rows) * n, C(0.0, 0.0));
+    vt.assign(static_cast<std::size_t>(n) * cols, C(0.0, 0.0));
+    for (int r = 0; r < n; ++r) {
+        int j = order[r];
+        s[r] = norms[j];
+        double inverse = norms[j] > 0 ? 1.0 / norms[j] : 0.0;
+        const C* column = &w[static_cast<std::size_t>(j) * m];
+        const C* rotation = &v[static_cast<std::size_t>(j) * n];
+        if (!transposed) {
+            for (int i = 0; i < rows; ++i) u[static_cast<std::size_t>(i) * n + r] = column[i] * inverse;
+            for (int k = 0; k < cols; ++k) vt[static_cast<std::size_t>(r) * cols + k] = std::conj(rotation[k]);
+        } else {
+            for (int i = 0; i < rows; ++i) u[static_cast<std::size_t>(i) * n + r] = rotation[i];
+            for (int k = 0; k < cols; ++k) vt[static_cast<std::size_t>(r) * cols + k] = std::conj(column[k]) * inverse;
+        }
+    }
+}
+
+/*
+Состояние в виде матричного произведения (MPS) для схем с малой запутанностью
+- Кубит q - тензор A[q] размера left x 2 x right, хранится как [(l * 2 + s) * right + r]
+- Память O(n * bond^2) вместо 2^n: 60+ кубитов при небольшой запутанности
+- Однокубитный вентиль - на месте, без изменения размеров
+- Двухкубитный вентиль на соседних кубитах: свертка двух тензоров,
+  вентиль 4x4, SVD и отбрасывание сингулярных чисел сверх max_bond
+  (и меньших cutoff от старшего); для несоседних кубитов - цепочка SWAP
+- Поддерживается смешанная каноническая форма с центром center:
+  отбрасывание оптимально, а отброшенный вес - точная мера ошибки
+ */
+class MpsState {
+public:
+    typedef std::complex<double> Amplitude;
+    typedef StateVector::Matrix2 Matrix2;
+    typedef std::array<Amplitude, 16> Matrix4;  // [выход * 4 + вход], вход = s_левый * 2 + s_правый
+
+    explicit MpsState(int max_bond = 64, double cutoff = 1e-12) : bond_limit(max_bond), cutoff(cutoff) {}
+
+    void set_max_bond(int max_bond) { bond_limit = max_bond; }
+    int max_bond() const { return bond_limit; }
+
+    /*
+    Состояние |0...0>: все связи размера 1
+     */
+    void reset(int qubits) {
+        qubit_count = qubits;
+        tensors.resize(qubits);
+        left.assign(qubits, 1);
+        right.assign(qubits, 1);
+        for (std::vector<Amplitude>& tensor : tensors) tensor.assign(2, Amplitude(0.0, 0.0));
+        for (std::vector<Amplitude>& tensor : tensors) tensor[0] = Amplitude(1.0, 0.0);
+        center = 0;
+        discarded = 0.0;
+        truncations = 0;
+    }
+
+    int qubits() const { return qubit_count; }
+
+    // Наибольшая связь сейчас
+    int bond_dimension() const {
+        int bond = 1;
+        for (int q = 0; q < qubit_count; ++q) bond = std::max(bond, right[q]);
+        return bond;
+    }
+
+    // Байт в тензорах
+    std::size_t memory_bytes() const {
+        std::size_t bytes = 0;
+        for (const std::vector<Amplitude>& tensor : tensors) bytes += tensor.size() * sizeof(Amplitude);
+        return bytes;
+    }
+
+    // Сумма отброшенных весов (квадратов сингулярных чисел) с reset;
+    // верность состояния не ниже 1 - discarded_weight() (приближенно)
+    double discarded_weight() const { return discarded; }
+    int truncated_gates() const { return truncations; }
+
+    void apply_single(int target, const Matrix2& m) {
+        std::vector<Amplitude>& tensor = tensors[target];
+        int r_size = right[target];
+        for (int l = 0; l < left[target]; ++l) {
+            Amplitude* zero = &tensor[static_cast<std::size_t>(l * 2) * r_size];
+            Amplitude* one = zero + r_size;
+            for (int r = 0; r < r_size; ++r) {
+                Amplitude a0 = zero[r], a1 = one[r];
+                zero[r] = m[0] * a0 + m[1] * a1;
+                one[r] = m[2] * a0 + m[3] * a1;
+            }
+        }
+    }
+
+    void apply_cx(int control, int target) {
+        Matrix4 gate = Matrix4();
+        // Вход (s_левый, s_правый); control может быть левым или правым
+        for (int in = 0; in < 4; ++in) {
+            int bits[2] = {in >> 1, in & 1};
+            int c = control < target ? 0 : 1;
+            if (bits[c]) bits[1 - c] ^= 1;
+            gate[(bits[0] * 2 + bits[1]) * 4 + in] = 1.0;
+        }
+        apply_two(control, target, gate);
+    }
+
+    void apply_cz(int control, int target) {
+        Matrix4 gate = Matrix4();
+        for (int in = 0; in < 4; ++in) gate[in * 4 + in] = in == 3 ? -1.0 : 1.0;
+        apply_two(control, target, gate);
+    }
+
+    /*
+    Вентиль gate на кубитах a, b (в порядке номеров: левый - меньший)
+    Несоседние кубиты сводятся SWAP-ами к соседним и возвращаются обратно
+     */
+    void apply_two(int a, int b, const Matrix4& gate) {
+        int low = std::min(a, b), high = std::max(a, b);
+        for (int site = low; site + 1 < high; ++site) apply_adjacent(site, swap_gate());
+        apply_adjacent(high - 1, gate);
+        for (int site = high - 2; site >= low; --site) apply_adjacent(site, swap_gate());
+    }
+
+    /*
+    Среднее значение строки Паули (без коэффициента)
+    Свертка переходных матриц только на отрезке от первого до последнего
+    нетривиального кубита (с центром): левее центра тензоры
+    левоканонические, правее - правоканонические и дают единичные матрицы
+    Строка с кубитами за пределами состояния - NaN, как у вектора состояния
+     */
+    double expectation_pauli(const PauliString& pauli) const {
+        if (!pauli.fits(qubit_count)) return std::numeric_limits<double>::quiet_NaN();
+        std::uint64_t support = pauli.x_mask | pauli.z_mask;
+        if (support == 0) return 1.0;
+        int first = __builtin_ctzll(support);
+        int last = 63 - __builtin_clzll(support);
+        int begin = std::min(first, center), end = std::max(last, center);
+
+        std::vector<Amplitude> transfer(static_cast<std::size_t>(left[begin]) * left[begin], Amplitude(0.0, 0.0));
+        for (int l = 0; l < left[begin]; ++l) transfer[static_cast<std::size_t>(l) * left[begin] + l] = 1.0;
+        std::vector<Amplitude> half;
+        std::vector<Amplitude> next;
+        for (int q = begin; q <= end; ++q) {
+            const std::vector<Amplitude>& tensor = tensors[q];
+            const int ls = left[q], rs = right[q];
+            const bool flip = (pauli.x_mask >> q) & 1;
+            const bool sign = (pauli.z_mask >> q) & 1;
+
+            // half[l][s][r'] = sum_l' E[l][l'] A[l'][s][r']
+            half.assign(static_cast<std::size_t>(ls) * 2 * rs, Amplitude(0.0, 0.0));
+            for (int l = 0; l < ls; ++l) {
+                for (int lp = 0; lp < ls; ++lp) {
+                    Amplitude e = transfer[static_cast<std::size_t>(l) * ls + lp];
+                    if (e == Amplitude(0.0, 0.0)) continue;
+                    const Amplitude* source = &tensor[static_cast<std::size_t>(lp) * 2 * rs];
+                    Amplitude* target = &half[static_cast<std::size_t>(l) * 2 * rs];
+                    for (int k = 0; k < 2 * rs; ++k) target[k] += e * source[k];
+                }
+            }
+
+            // E'[r][r'] = sum_{l,s} conj(A[l][s][r]) P[s][s ^ x] half[l][s ^ x][r']
+            next.assign(static_cast<std::size_t>(rs) * rs, Amplitude(0.0, 0.0));
+            for (int l = 0; l < ls; ++l) {
+                for (int s = 0; s < 2; ++s) {
+                    int sp = flip ? s ^ 1 : s;
+                    Amplitude factor = pauli_element(flip, sign, s);
+                    const Amplitude* bra = &tensor[static_cast<std::size_t>(l * 2 + s) * rs];
+                    const Amplitude* ket = &half[static_cast<std::size_t>(l * 2 + sp) * rs];
+                    for (int r = 0; r < rs; ++r) {
+                        Amplitude weight = std::conj(bra[r]) * factor;
+                        if (weight == Amplitude(0.0, 0.0)) continue;
+                        Amplitude* row = &next[static_cast<std::size_t>(r) * rs];
+                        for (int rp = 0; rp < rs; ++rp) row[rp] += weight * ket[rp];
+                    }
+                }
+            }
+            transfer.swap(next);
+        }
+
+        Amplitude trace(0.0, 0.0);
+        for (int r = 0; r < right[end]; ++r) trace += transfer[static_cast<std::size_t>(r) * right[end] + r];
+        return trace.real();
+    }
+
+    double expectation_z(int qubit) const {
+        return expectation_pauli(PauliString{0, std::uint64_t(1) << qubit, 1.0});
+    }
+
+private:
+    // Элемент P[s][s ^ x] однокубитной матрицы Паули (I, X, Y, Z по flip, sign)
+    static Amplitude pauli_element(bool flip, bool sign, int s) {
+        if (flip && sign) return s == 0 ? Amplitude(0.0, -1.0) : Amplitude(0.0, 1.0);  // Y
+        if (sign) return s == 0 ? 1.0 : -1.0;                                           // Z
+        return 1.0;                                                                      // I, X
+    }
+
+    static const Matrix4& swap_gate() {
+        static const Matrix4 gate = [] {
+            Matrix4 m = Matrix4();
+            m[0 * 4 + 0] = m[2 * 4 + 1] = m[1 * 4 + 2] = m[3 * 4 + 3] = 1.0;
+            return m;
+        }();
+        return gate;
+    }
+
+    /*
+    Вентиль на соседних кубитах site, site + 1
+     */
+    void apply_adjacent(int site, const Matrix4& gate) {
+        move_center(site);
+        const int ls = left[site], mid = right[site], rs = right[site + 1];
+        const std::vector<Amplitude>& a = tensors[site];
+        const std::vector<Amplitude>& b = tensors[site + 1];
+
+        // theta[l][s1][s2][r] = sum_k A[l][s1][k] B[k][s2][r]
+        theta.assign(static_cast<std::size_t>(ls) * 4 * rs, Amplitude(0.0, 0.0));
+        for (int l = 0; l < ls; ++l) {
+            for (int s1 = 0; s1 < 2; ++s1) {
+                for (int k = 0; k < mid; ++k) {
+                    Amplitude x = a[static_cast<std::size_t>(l * 2 + s1) * mid + k];
+                    if (x == Amplitude(0.0, 0.0)) continue;
+                    for (int s2 = 0; s2 < 2; ++s2) {
+                        const Amplitude* source = &b[static_cast<std::size_t>(k * 2 + s2) * rs];
+                        Amplitude* target = &theta[(static_cast<std::size_t>(l) * 4 + s1 * 2 + s2) * rs];
+                        for (int r = 0; r < rs; ++r) target[r] += x * source[r];
+                    }
+                }
+            }
+        }
+
+        // Вентиль и матрица (l, s1) x (s2, r) для разложения
+        matrix.assign(static_cast<std::size_t>(ls) * 4 * rs, Amplitude(0.0, 0.0));
+        for (int l = 0; l < ls; ++l) {
+            const Amplitude* in = &theta[static_cast<std::size_t>(l) * 4 * rs];
+            for (int out = 0; out < 4; ++out) {
+                Amplitude* target = &matrix[(static_cast<std::size_t>(l * 2 + (out >> 1)) * 2 + (out & 1)) * rs];
+                for (int k = 0; k < 4; ++k) {
+                    Amplitude g = gate[out * 4 + k];
+                    if (g == Amplitude(0.0, 0.0)) continue;
+                    for (int r = 0; r < rs; ++r) target[r] += g * in[k * rs + r];
+                }
+            }
+        }
+        jacobi_svd(matrix, 2 * ls, 2 * rs, u, singular, vt);
+
+        // Отбрасывание: не больше bond_limit и не меньше cutoff от старшего
+        int full = static_cast<int>(singular.size());
+        int keep = 0;
+        double total = 0.0, kept = 0.0;
+        for (int k = 0; k < full; ++k) total += singular[k] * singular[k];
+        while (keep < full && keep < bond_limit && singular[keep] > cutoff * singular[0]) {
+            kept += singular[keep] * singular[keep];
+            ++keep;
+        }
+        if (keep == 0) keep = 1, kept = singular[0] * singular[0];
+        if (total - kept > 1e-14 * total) {
+            discarded += (total - kept) / total;
+            truncations++;
+        }
+        double scale = kept > 0 ? 1.0 / std::sqrt(kept) : 1.0;
+
+        // A = u (левоканонический), B = s * vt (новый центр)
+        std::vector<Amplitude>& new_a = tensors[site];
+        std::vector<Amplitude>& new_b = tensors[site + 1];
+        new_a.resize(static_cast<std::size_t>(ls) * 2 * keep);
+        for (int row = 0; row < 2 * ls; ++row) {
+            for (int k = 0; k < keep; ++k) new_a[static_cast<std::size_t>(row) * keep + k] = u[static_cast<std::size_t>(row) * full + k];
+        }
+        new_b.resize(static_cast<std::size_t>(keep) * 2 * rs);
+        for (int k = 0; k < keep; ++k) {
+            double weight = singular[k] * scale;
+            for (int col = 0; col < 2 * rs; ++col) {
+                new_b[static_cast<std::size_t>(k) * 2 * rs + col] = weight * vt[static_cast<std::size_t>(k) * 2 * rs + col];
+            }
+        }
+        right[site] = keep;
+        left[site + 1] = keep;
+        center = site + 1;
+    }
+
+    /*
+    Перенос центра канонической формы на кубит site разложением
+    тензоров по пути (без отбрасывания значимых чисел)
+     */
+    void move_center(int site) {
+        while (center < site) shift_right();
+        while (center > site) shift_left();
+    }
+
+    void shift_right() {
+        const int q = center, ls = left[q], rs = right[q], ns = right[q + 1];
+        jacobi_svd(tensors[q], 2 * ls, rs, u, singular, vt);
+        int keep = significant();
+        int full = static_cast<int>(singular.size());
+        std::vector<Amplitude>& a = tensors[q];
+        a.resize(static_cast<std::size_t>(ls) * 2 * keep);
+        for (int row = 0; row < 2 * ls; ++row) {
+            for (int k = 0; k < keep; ++k) a[static_cast<std::size_t>(row) * keep + k] = u[static_cast<std::size_t>(row) * full + k];
+        }
+        // Следующий тензор: (s * vt) * B
+        const std::vector<Amplitude>& b = tensors[q + 1];
+        theta.assign(static_cast<std::size_t>(keep) * 2 * ns, Amplitude(0.0, 0.0));
+        for (int k = 0; k < keep; ++k) {
+            for (int j = 0; j < rs; ++j) {
+                Amplitude x = singular[k] * vt[static_cast<std::size_t>(k) * rs + j];
+                const Amplitude* source = &b[static_cast<std::size_t>(j) * 2 * ns];
+                Amplitude* target = &theta[static_cast<std::size_t>(k) * 2 * ns];
+                for (int c = 0; c < 2 * ns; ++c) target[c] += x * source[c];
+            }
+        }
+        tensors[q + 1].swap(theta);
+        right[q] = keep;
+        left[q + 1] = keep;
+        center = q + 1;
+    }
+
+    void shift_left() {
+        const int q = center, ls = left[q], rs = right[q], ps = left[q - 1];
+        jacobi_svd(tensors[q], ls, 2 * rs, u, singular, vt);
+        int keep = significant();
+        int full = static_cast<int>(singular.size());
+        std::vector<Amplitude>& a = tensors[q];
+        a.assign(vt.begin(), vt.begin() + static_cast<std::size_t>(keep) * 2 * rs);
+        // Предыдущий тензор: P * (u * s)
+        const std::vector<Amplitude>& p = tensors[q - 1];
+        theta.assign(static_cast<std::size_t>(ps) * 2 * keep, Amplitude(0.0, 0.0));
+        for (int row = 0; row < 2 * ps; ++row) {
+            for (int j = 0; j < ls; ++j) {
+                Amplitude x = p[static_cast<std::size_t>(row) * ls + j];
+                if (x == Amplitude(0.0, 0.0)) continue;
+                for (int k = 0; k < keep; ++k) {
+                    theta[static_cast<std::size_t>(row) * keep + k] += x * u[static_cast<std::size_t>(j) * full + k] * singular[k];
+                }
+            }
+        }
+        tensors[q - 1].swap(theta);
+        left[q] = keep;
+        right[q - 1] = keep;
+        center = q - 1;
+    }
+
+    // Число ненулевых (с точностью до cutoff) сингулярных чисел
+    int significant() const {
+        int keep = 1;
+        while (keep < static_cast<int>(singular.size()) && singular[keep] > cutoff * singular[0]) ++keep;
+        return keep;
+    }
+
+    int bond_limit;
+    double cutoff;
+    int qubit_count = 0;
+    int center = 0;
+    double discarded = 0.0;
+    int truncations = 0;
+    std::vector<std::vector<Amplitude>> tensors;
+    std::vector<int> left;    // Размер левой связи тензора
+    std::vector<int> right;   // Размер правой связи тензора
+
+    // Рабочие буферы, переиспользуются между вентилями
+    std::vector<Amplitude> theta;
+    std::vector<Amplitude> matrix;
+    std::vector<Amplitude> u;
+    std::vector<Amplitude> vt;
+    std::vector<double> singular;
+};
+
+/*
+Энергия на MPS: средние значения строк по одной свертке на строку
+ */
+inline double pauli_energy(const MpsState& state, const std::vector<PauliString>& terms) {
+    double energy = 0.0;
+    for (const PauliString& term : terms) energy += term.coefficient * state.expectation_pauli(term);
+    return energy;
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef PAULI_HPP
+#define PAULI_HPP
+
+#include <vector>
+#include <map>
+#include <string>
+#include <complex>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <boost/thread.hpp>
+#include "circuit.hpp"
+
+/*
+Строка Паули с коэффициентом
+- x_mask - кубиты с X или Y (переворот бита)
+- z_mask - кубиты с Z или Y (знак)
+Y = i X Z, поэтому P|j> = i^{число Y} (-1)^{popcount(j & z_mask)} |j ^ x_mask>
+ */
+struct PauliString {
+    std::uint64_t x_mask;
+    std::uint64_t z_mask;
+    double coefficient;
+
+    /*
+    Из текста вида "XIZY": символ q относится к кубиту q
+     */
+    static PauliString from_text(const std::string& text, double coefficient = 1.0) {
+        PauliString pauli{0, 0, coefficient};
+        for (std::size_t q = 0; q < text.size(); ++q) {
+            std::uint64_t bit = std::uint64_t(1) << q;
+            if (text[q] == 'X' || text[q] == 'Y') pauli.x_mask |= bit;
+            if (text[q] == 'Z' || text[q] == 'Y') pauli.z_mask |= bit;
+        }
+        return pauli;
+    }
+
+    int y_count() const { return __builtin_popcountll(x_mask & z_mask); }
+
+    // Строка действует только на кубиты 0..qubits-1
+    bool fits(int qubits) const {
+        return qubits >= 64 || ((x_mask | z_mask) >> qubits) == 0;
+    }
+};
+
+/*
+Запуск body(begin, end) на threads потоках по равным частям [0, count)
+ */
+template <typename Body>
+void parallel_ranges(int threads, std::size_t count, Body body) {
+    if (threads <= 1 || count < 4096) {
+        body(std::size_t(0), count);
+        return;
+    }
+    boost::thread_group group;
+    std::size_t chunk = (count + threads - 1) / threads;
+    for (int t = 0; t < threads; ++t) {
+        std::size_t begin = t * chunk;
+        std::size_t end = begin + chunk < count ? begin + chunk : count;
+        if (begin >= end) break;
+        group.create_thread([&body, begin, end] { body(begin, end); });
+    }
+    group.join_all();
+}
+
+/*
+Один шаг преобразования Уолша-Адамара на count элементах (кратно 2 * stride)
+ */
+inline void walsh_stage(double* re, double* im, std::size_t count, std::size_t stride) {
+    for (std::size_t base = 0; base < count; base += 2 * stride) {
+        double* lr = re + base;
+        double* li = im + base;
+        double* hr = lr + stride;
+        double* hi = li + stride;
+        for (std::size_t i = 0; i < stride; ++i) {
+            double r = lr[i], m = li[i];
+            lr[i] = r + hr[i];
+            li[i] = m + hi[i];
+            hr[i] = r - hr[i];
+            hi[i] = m - hi[i];
+        }
+    }
+}
+
+/*
+Средние значения многих строк Паули в одном состоянии
+- У строк с одинаковой x_mask общее произведение
+  f(j) = conj(psi[j ^ x]) psi[j], строки различаются только знаком
+  (-1)^{popcount(j & z)} и множителем i^{число Y} (сами строки при этом
+  могут и не коммутировать, например X и Y)
+- Для группы считается f один раз; если строк в группе больше 2n,
+  все знаковые суммы получаются одним преобразованием Уолша-Адамара
+  f за n проходов, иначе - прямой суммой по группе за один проход
+- Буферы f хранятся раздельно (вещественная и мнимая части), проходы
+  по ним векторизуются; проходы делятся на threads потоков
+values[k] - среднее значение строки k без коэффициента; суммы всегда
+в double, в том числе для вектора одинарной точности; строка с кубитами
+за пределами состояния (!fits) получает NaN
+ */
+template <typename Real>
+void pauli_expectations(const BasicStateVector<Real>& state, const std::vector<PauliString>& terms,
+                        std::vector<double>& values, int threads = 1) {
+    typedef std::complex<double> C;
+    const std::size_t size = state.size();
+    const int qubits = state.qubits();
+    values.assign(terms.size(), 0.0);
+
+    std::map<std::uint64_t, std::vector<std::size_t>> groups;
+    for (std::size_t k = 0; k < terms.size(); ++k) {
+        if (terms[k].fits(qubits)) {
+            groups[terms[k].x_mask].push_back(k);
+        } else {
+            values[k] = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    std::vector<double> f_re;
+    std::vector<double> f_im;
+    const Real* amplitudes = reinterpret_cast<const Real*>(&state[0]);
+
+    for (const std::pair<const std::uint64_t, std::vector<std::size_t>>& group : groups) {
+        const std::uint64_t x = group.first;
+        const std::vector<std::size_t>& members = group.second;
+        std::vector<C> sums(members.size(), C(0.0, 0.0));
+
+        if (members.size() > static_cast<std::size_t>(2 * qubits)) {
+            // f(j) и преобразование Уолша-Адамара: F(z) = sum_j f(j) (-1)^{popcount(j & z)}
+            f_re.resize(size);
+            f_im.resize(size);
+            parallel_ranges(threads, size, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t j = begin; j < end; ++j) {
+                    std::size_t partner = j ^ x;
+                    double ar = amplitudes[2 * partner], ai = amplitudes[2 * partner + 1];
+                    double br = amplitudes[2 * j], bi = amplitudes[2 * j + 1];
+                    f_re[j] = ar * br + ai * bi;
+                    f_im[j] = ar * bi - ai * br;
+                }
+            });
+            // Малые шаги - внутри блоков по 2^12 элементов (в кеше),
+            // большие - проходами по всему буферу
+            const std::size_t block = size < 4096 ? size : 4096;
+            parallel_ranges(threads, size / block, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t b = begin; b < end; ++b) {
+                    double* re = &f_re[b * block];
+                    double* im = &f_im[b * block];
+                    for (std::size_t stride = 1; stride < block; stride *= 2) {
+                        walsh_stage(re, im, block, stride);
+                    }
+                }
+            });
+            for (std::size_t stride = block; stride < size; stride *= 2) {
+                std::size_t span = 2 * stride;
+                parallel_ranges(threads, size / span, [&](std::size_t begin, std::size_t end) {
+                    walsh_stage(&f_re[begin * span], &f_im[begin * span], (end - begin) * span, stride);
+                });
+            }
+            for (std::size_t m = 0; m < members.size(); ++m) {
+                std::size_t z = static_cast<std::size_t>(terms[members[m]].z_mask);
+                sums[m] = C(f_re[z], f_im[z]);
+            }
+        } else {
+            // Прямая сумма: один проход, частичные суммы потоков
+            boost::mutex merge_mutex;
+            parallel_ranges(threads, size, [&](std::size_t begin, std::size_t end) {
+                std::vector<double> re(members.size(), 0.0);
+                std::vector<double> im(members.size(), 0.0);
+                for (std::size_t j = begin; j < end; ++j) {
+                    std::size_t partner = j ^ x;
+                    double ar = amplitudes[2 * partner], ai = amplitudes[2 * partner + 1];
+                    double br = amplitudes[2 * j], bi = amplitudes[2 * j + 1];
+                    double pr = ar * br + ai * bi;
+                    double pi = ar * bi - ai * br;
+                    for (std::size_t m = 0; m < members.size(); ++m) {
+                        double sign = __builtin_parityll(j & terms[members[m]].z_mask) ? -1.0 : 1.0;
+                        re[m] += sign * pr;
+                        im[m] += sign * pi;
+                    }
+                }
+                boost::lock_guard<boost::mutex> lock(merge_mutex);
+                for (std::size_t m = 0; m < members.size(); ++m) sums[m] += C(re[m], im[m]);
+            });
+        }
+
+        // Множитель i^{число Y}; результат вещественный для эрмитовой строки
+        static const C phases[4] = {C(1, 0), C(0, 1), C(-1, 0), C(0, -1)};
+        for (std::size_t m = 0; m < members.size(); ++m) {
+            values[members[m]] = (phases[terms[members[m]].y_count() & 3] * sums[m]).real();
+        }
+    }
+}
+
+/*
+Энергия: сумма коэффициентов, умноженных на средние значения строк
+ */
+template <typename Real>
+double pauli_energy(const BasicStateVector<Real>& state, const std::vector<PauliString>& terms, int threads = 1) {
+    std::vector<double> values;
+    pauli_expectations(state, terms, values, threads);
+    double energy = 0.0;
+    for (std::size_t k = 0; k < terms.size(); ++k) energy += terms[k].coefficient * values[k];
+    return energy;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef REALTIME_HPP
+#define REALTIME_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+/*
+Подготовка процесса и потоков к работе с ограниченной задержкой
+- Все функции возвращают false, если ОС не разрешила действие
+  (нет CAP_SYS_NICE / CAP_IPC_LOCK, лимиты RLIMIT_RTPRIO и RLIMIT_MEMLOCK);
+  тогда поток продолжает работать как обычный
+- Вызываются до входа в рабочий цикл: сами они делают системные вызовы
+ */
+
+/*
+Закрепление всех текущих и будущих страниц процесса в памяти,
+чтобы на пути обработки не было страничных отказов
+ */
+inline bool lock_process_memory() {
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+}
+
+// Снятие закрепления (MCL_FUTURE действует на весь процесс до этого вызова)
+inline void unlock_process_memory() {
+    munlockall();
+}
+
+/*
+Перевод текущего потока в SCHED_FIFO с приоритетом priority (1-99)
+ */
+inline bool set_thread_fifo(int priority) {
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+/*
+Предварительное касание bytes байт стека текущего потока,
+чтобы страницы стека были выделены (и закреплены) до рабочего цикла
+ */
+template <std::size_t Bytes>
+inline void prefault_stack() {
+    volatile unsigned char stack[Bytes];
+    for (std::size_t offset = 0; offset < Bytes; offset += 4096) {
+        stack[offset] = 0;
+    }
+    (void)stack[0];
+}
+
+#endif
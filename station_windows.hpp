@@ -0,0 +1,155 @@
+#ifndef STATION_WINDOWS_HPP
+#define STATION_WINDOWS_HPP
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+/*
+Итог закрытого окна станции
+ */
+struct WindowSummary {
+    int station;
+    std::int64_t start_ms;      // Начало окна во времени событий
+    int packets;
+    int critical;
+    int missing;                // Пропуски в номерах пакетов внутри окна
+};
+
+/*
+Окна по времени событий для каждой станции с водяным знаком
+- Пакет попадает в окно по своему времени события, а не по порядку прихода,
+  поэтому перестановки (приоритетная очередь, сеть, шарды) не ломают окна
+- Водяной знак = максимальное увиденное время события - допустимое опоздание;
+  окна, конец которых не позже водяного знака, закрываются
+- Пакеты в уже закрытые окна считаются опоздавшими и отбрасываются
+- Память ограничена: у станции не больше max_open окон, при переполнении
+  самые старые окна закрываются принудительно
+- Закрытые окна передаются в sink
+ */
+class StationWindows {
+public:
+    typedef std::function<void(const WindowSummary&)> Sink;
+
+    StationWindows(int stations, std::int64_t window_ms, std::int64_t allowed_lateness_ms, int max_open,
+                   Sink sink) :
+        sink(sink),
+        window_ms(window_ms),
+        allowed_lateness_ms(allowed_lateness_ms),
+        max_open(max_open),
+        states(stations),
+        slots(static_cast<std::size_t>(stations) * max_open)
+    {}
+
+    /*
+    Учет пакета; false - пакет опоздал и отброшен
+     */
+    bool add(int station, std::uint32_t sequence, std::int64_t event_time_ms, bool is_critical) {
+        if (event_time_ms > max_event_time) max_event_time = event_time_ms;
+
+        StationState& state = states[station];
+        if (state.seen && sequence < state.highest_sequence) reordered++;
+        if (!state.seen || sequence > state.highest_sequence) state.highest_sequence = sequence;
+        state.seen = true;
+
+        std::int64_t index = event_time_ms / window_ms;
+        if (index < state.next_final) {
+            late++;
+            return false;
+        }
+
+        // Окно слишком далеко впереди - закрываем старые, чтобы освободить место
+        if (index >= state.next_final + max_open) {
+            std::int64_t limit = index - max_open + 1;
+            forced += close_until(station, limit);
+        }
+
+        Window& window = slot(station, index);
+        if (window.index != index) {
+            window = Window();
+            window.index = index;
+            window.min_sequence = sequence;
+            window.max_sequence = sequence;
+        }
+        window.packets++;
+        if (is_critical) window.critical++;
+        if (sequence < window.min_sequence) window.min_sequence = sequence;
+        if (sequence > window.max_sequence) window.max_sequence = sequence;
+        return true;
+    }
+
+    /*
+    Закрытие окон, которые прошел водяной знак
+     */
+    void advance() {
+        std::int64_t watermark = max_event_time - allowed_lateness_ms;
+        std::int64_t limit = watermark >= 0 ? watermark / window_ms : 0;
+        if (limit <= closed_until) return;
+        closed_until = limit;
+
+        for (int station = 0; station < static_cast<int>(states.size()); ++station) {
+            close_until(station, limit);
+        }
+    }
+
+    // Счетчики
+    std::uint64_t finalized = 0;  // Закрыто окон с данными
+    std::uint64_t late = 0;       // Опоздавших пакетов
+    std::uint64_t reordered = 0;  // Пакетов, пришедших после пакета с большим номером
+    std::uint64_t missing = 0;    // Пропусков в номерах внутри закрытых окон
+    std::uint64_t forced = 0;     // Окон, закрытых из-за ограничения памяти
+
+private:
+    struct Window {
+        std::int64_t index = -1;  // Номер окна, -1 - ячейка пуста
+        int packets = 0;
+        int critical = 0;
+        std::uint32_t min_sequence = 0;
+        std::uint32_t max_sequence = 0;
+    };
+
+    struct StationState {
+        std::int64_t next_final = 0;     // Первое незакрытое окно
+        std::uint32_t highest_sequence = 0;
+        bool seen = false;
+    };
+
+    Window& slot(int station, std::int64_t index) {
+        return slots[static_cast<std::size_t>(station) * max_open + index % max_open];
+    }
+
+    /*
+    Закрытие окон станции с номерами меньше limit
+    Возвращает число закрытых окон с данными
+     */
+    int close_until(int station, std::int64_t limit) {
+        StationState& state = states[station];
+        int closed = 0;
+        std::int64_t last = limit < state.next_final + max_open ? limit : state.next_final + max_open;
+        for (std::int64_t index = state.next_final; index < last; ++index) {
+            Window& window = slot(station, index);
+            if (window.index != index) continue;
+
+            WindowSummary summary{station, index * window_ms, window.packets, window.critical,
+                                  static_cast<int>(window.max_sequence - window.min_sequence + 1) - window.packets};
+            finalized++;
+            missing += summary.missing > 0 ? summary.missing : 0;
+            if (sink) sink(summary);
+            window.index = -1;
+            closed++;
+        }
+        if (limit > state.next_final) state.next_final = limit;
+        return closed;
+    }
+
+    Sink sink;
+    std::int64_t window_ms;
+    std::int64_t allowed_lateness_ms;
+    int max_open;
+    std::int64_t max_event_time = 0;
+    std::int64_t closed_until = 0;     // Окна с меньшими номерами закрыты у всех станций
+    std::vector<StationState> states;
+    std::vector<Window> slots;         // max_open ячеек на станцию
+};
+
+#endif
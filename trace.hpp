@@ -0,0 +1,283 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <atomic>
+#include <cstdint>
+#include <boost/thread.hpp>
+#include <boost/chrono.hpp>
+#include "tsc_clock.hpp"
+
+/*
+Событие трассировки в формате Chrome trace-event
+- name, category, arg_names - строковые литералы (до 6 аргументов), не копируются
+- phase: 'X' - интервал, 'i' - мгновенное событие, 'C' - счетчик
+ */
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    char phase;
+    char scope;                 // Для 'i': 't' - поток, 'g' - весь трейс
+    std::int64_t ts;            // Начало, мкс от запуска трассировки
+    std::int64_t dur;           // Длительность для 'X', мкс
+    int arg_count;
+    const char* arg_names[6];
+    std::int64_t arg_values[6];
+};
+
+/*
+Трассировщик временной шкалы (открывается в chrome://tracing и Perfetto)
+- Каждый поток пишет в свой буфер, контендует только с фоновым потоком записи
+- Фоновый поток раз в 100 мс забирает буферы и пишет их в файл
+- Когда трассировка выключена, запись события - одна атомарная проверка
+ */
+class Tracer {
+public:
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    bool enabled() const { return active.load(std::memory_order_relaxed); }
+
+    /*
+    Запуск трассировки в файл path
+     */
+    void start(const std::string& path) {
+        boost::unique_lock<boost::mutex> lock(registry_mutex);
+        if (active) return;
+        output.open(path.c_str());
+        output << "{\"traceEvents\":[\n";
+        first_event = true;
+        origin = TscClock::now();
+        stopping = false;
+        active = true;
+        flusher = boost::thread(&Tracer::flush_thread, this);
+    }
+
+    /*
+    Остановка: запись оставшихся событий и закрытие файла
+     */
+    void stop() {
+        {
+            boost::unique_lock<boost::mutex> lock(registry_mutex);
+            if (!active) return;
+            active = false;
+            stopping = true;
+        }
+        flush_condition.notify_all();
+        flusher.join();
+        flush();
+        output << "\n]}\n";
+        output.close();
+    }
+
+    std::int64_t now() const {
+        return static_cast<std::int64_t>(TscClock::instance().to_us(TscClock::now() - origin));
+    }
+
+    void record(const TraceEvent& event) {
+        if (!enabled()) return;
+        ThreadBuffer& buffer = local_buffer();
+        boost::lock_guard<boost::mutex> lock(buffer.mutex);
+        buffer.events.push_back(event);
+    }
+
+    /*
+    Имя текущего потока на временной шкале
+     */
+    void name_thread(const std::string& name) {
+        if (!enabled()) return;
+        ThreadBuffer& buffer = local_buffer();
+        boost::lock_guard<boost::mutex> lock(buffer.mutex);
+        buffer.name = name;
+        buffer.name_written = false;
+    }
+
+    void instant(const char* name, const char* category,
+                 const char* arg1 = nullptr, std::int64_t value1 = 0,
+                 const char* arg2 = nullptr, std::int64_t value2 = 0) {
+        if (!enabled()) return;
+        TraceEvent event = make_event(name, category, 'i', now());
+        add_arg(event, arg1, value1);
+        add_arg(event, arg2, value2);
+        record(event);
+    }
+
+    /*
+    Мгновенное событие, видимое на всех потоках (смена режима и т.п.)
+     */
+    void global_instant(const char* name, const char* category) {
+        if (!enabled()) return;
+        TraceEvent event = make_event(name, category, 'i', now());
+        event.scope = 'g';
+        record(event);
+    }
+
+    void counter(const char* name, std::int64_t value) {
+        if (!enabled()) return;
+        TraceEvent event = make_event(name, "counter", 'C', now());
+        add_arg(event, "value", value);
+        record(event);
+    }
+
+    static TraceEvent make_event(const char* name, const char* category, char phase, std::int64_t ts) {
+        TraceEvent event = TraceEvent();
+        event.name = name;
+        event.category = category;
+        event.phase = phase;
+        event.scope = 't';
+        event.ts = ts;
+        return event;
+    }
+
+    static void add_arg(TraceEvent& event, const char* name, std::int64_t value) {
+        if (name == nullptr || event.arg_count == 6) return;
+        event.arg_names[event.arg_count] = name;
+        event.arg_values[event.arg_count] = value;
+        ++event.arg_count;
+    }
+
+private:
+    struct ThreadBuffer {
+        boost::mutex mutex;
+        std::vector<TraceEvent> events;
+        std::string name;
+        bool name_written = false;
+        int tid = 0;
+    };
+
+    Tracer() = default;
+
+    /*
+    Буфер текущего потока, создается при первом событии
+    Буферы принадлежат трассировщику и переживают свои потоки
+     */
+    ThreadBuffer& local_buffer() {
+        static thread_local ThreadBuffer* buffer = nullptr;
+        if (buffer == nullptr) {
+            boost::unique_lock<boost::mutex> lock(registry_mutex);
+            buffers.emplace_back(new ThreadBuffer());
+            buffer = buffers.back().get();
+            buffer->tid = static_cast<int>(buffers.size());
+        }
+        return *buffer;
+    }
+
+    void flush_thread() {
+        boost::unique_lock<boost::mutex> lock(registry_mutex);
+        while (!stopping) {
+            flush_condition.wait_for(lock, boost::chrono::milliseconds(100));
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+
+    /*
+    Забираем события всех буферов и пишем их в файл
+     */
+    void flush() {
+        boost::unique_lock<boost::mutex> flush_lock(flush_mutex);
+        std::vector<ThreadBuffer*> snapshot;
+        {
+            boost::unique_lock<boost::mutex> lock(registry_mutex);
+            for (const std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+                snapshot.push_back(buffer.get());
+            }
+        }
+
+        std::vector<TraceEvent> events;
+        for (ThreadBuffer* buffer : snapshot) {
+            std::string name;
+            {
+                boost::lock_guard<boost::mutex> lock(buffer->mutex);
+                events.swap(buffer->events);
+                if (!buffer->name_written && !buffer->name.empty()) {
+                    name = buffer->name;
+                    buffer->name_written = true;
+                }
+            }
+            if (!name.empty()) write_thread_name(buffer->tid, name);
+            for (const TraceEvent& event : events) {
+                write_event(buffer->tid, event);
+            }
+            events.clear();
+        }
+        output.flush();
+    }
+
+    void separator() {
+        if (!first_event) output << ",\n";
+        first_event = false;
+    }
+
+    void write_thread_name(int tid, const std::string& name) {
+        separator();
+        output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+               << ",\"args\":{\"name\":\"" << name << "\"}}";
+    }
+
+    void write_event(int tid, const TraceEvent& event) {
+        separator();
+        output << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+               << "\",\"ph\":\"" << event.phase << "\",\"ts\":" << event.ts
+               << ",\"pid\":1,\"tid\":" << tid;
+        if (event.phase == 'X') output << ",\"dur\":" << event.dur;
+        if (event.phase == 'i') output << ",\"s\":\"" << event.scope << "\"";
+        if (event.arg_count > 0) {
+            output << ",\"args\":{";
+            for (int i = 0; i < event.arg_count; ++i) {
+                if (i > 0) output << ",";
+                output << "\"" << event.arg_names[i] << "\":" << event.arg_values[i];
+            }
+            output << "}";
+        }
+        output << "}";
+    }
+
+    std::atomic<bool> active{false};
+    bool stopping = false;
+    std::uint64_t origin = 0;        // Метка TscClock запуска трассировки
+
+    boost::mutex registry_mutex;     // Список буферов и состояние трассировки
+    boost::mutex flush_mutex;        // Запись в файл
+    boost::condition_variable flush_condition;
+    boost::thread flusher;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    std::ofstream output;
+    bool first_event = true;
+};
+
+/*
+Интервал трассировки: начало в конструкторе, запись в деструкторе
+ */
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* category) :
+        event(Tracer::make_event(name, category, 'X', 0)),
+        enabled(Tracer::instance().enabled())
+    {
+        if (enabled) event.ts = Tracer::instance().now();
+    }
+
+    ~TraceScope() {
+        if (!enabled) return;
+        event.dur = Tracer::instance().now() - event.ts;
+        Tracer::instance().record(event);
+    }
+
+    void arg(const char* name, std::int64_t value) {
+        if (enabled) Tracer::add_arg(event, name, value);
+    }
+
+private:
+    TraceEvent event;
+    bool enabled;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TSC_CLOCK_HPP
+#define TSC_CLOCK_HPP
+
+#include <cstdint>
+#include <boost/chrono.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#define TSC_CLOCK_X86 1
+#endif
+
+/*
+Дешевые метки времени для инструментирования
+- На x86 с инвариантным TSC (CPUID 0x80000007, EDX бит 8) - rdtsc,
+  без системного вызова и обращения к vDSO
+- Иначе (другая архитектура, виртуальная машина без инвариантного TSC) -
+  steady_clock в наносекундах
+- Частота TSC калибруется по steady_clock при первом обращении (~20 мс)
+Метки годятся только для разностей в пределах одного процесса
+ */
+class TscClock {
+public:
+    static const TscClock& instance() {
+        static TscClock clock;
+        return clock;
+    }
+
+    /*
+    Текущая метка в тиках
+     */
+    static std::uint64_t now() {
+        return instance().ticks();
+    }
+
+    std::uint64_t ticks() const {
+#ifdef TSC_CLOCK_X86
+        if (invariant) return __rdtsc();
+#endif
+        return steady_ns();
+    }
+
+    double to_ns(std::uint64_t ticks) const { return ticks * ns_per_tick; }
+    double to_us(std::uint64_t ticks) const { return ticks * ns_per_tick / 1000.0; }
+    double to_ms(std::uint64_t ticks) const { return ticks * ns_per_tick / 1000000.0; }
+
+    std::uint64_t from_ms(double ms) const {
+        return static_cast<std::uint64_t>(ms * 1000000.0 / ns_per_tick);
+    }
+
+    bool uses_tsc() const { return invariant; }
+
+private:
+    TscClock() : invariant(detect_invariant_tsc()), ns_per_tick(1.0) {
+        if (invariant) calibrate();
+    }
+
+    static std::uint64_t steady_ns() {
+        return boost::chrono::duration_cast<boost::chrono::nanoseconds>(
+            boost::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static bool detect_invariant_tsc() {
+#ifdef TSC_CLOCK_X86
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) return false;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+        return (edx & (1u << 8)) != 0;
+#else
+        return false;
+#endif
+    }
+
+    /*
+    Число наносекунд на тик по интервалу ~20 мс
+     */
+    void calibrate() {
+#ifdef TSC_CLOCK_X86
+        std::uint64_t start_ns = steady_ns();
+        std::uint64_t start_ticks = __rdtsc();
+        std::uint64_t end_ns = start_ns;
+        while (end_ns - start_ns < 20000000) {
+            end_ns = steady_ns();
+        }
+        std::uint64_t end_ticks = __rdtsc();
+        if (end_ticks > start_ticks) {
+            ns_per_tick = static_cast<double>(end_ns - start_ns) / (end_ticks - start_ticks);
+        } else {
+            invariant = false;
+        }
+#endif
+    }
+
+    bool invariant;       // Используется ли TSC
+    double ns_per_tick;   // Наносекунд на тик (1 для steady_clock)
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef WAIT_ESTIMATOR_HPP
+#define WAIT_ESTIMATOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include "dary_heap.hpp"
+#include "latency_histogram.hpp"
+
+/*
+Оценка ожидания задачи до начала выполнения
+- Очередь учитывается по классам упакованного ключа (критичность + приоритет,
+  32 класса в порядке извлечения): счетчики меняются при постановке
+  и извлечении, оценка - проход по 32 счетчикам, O(1) от длины очереди
+- Впереди новой задачи: задачи ее класса и более приоритетных классов,
+  задачи, уже извлеченные потоками, но еще не начатые, и выполняемые
+- Длительность выполнения - скользящее среднее и p90 по гистограмме
+  последних задач (p90 пересчитывается раз в 16 завершений)
+ */
+struct WaitEstimate {
+    int ahead;            // Задач впереди, включая выполняемые
+    int servers;          // Одновременно выполняемых задач
+    double expected_ms;   // Ожидаемое время до начала по средней длительности
+    double pessimistic_ms; // То же по p90 длительности
+};
+
+class WaitEstimator {
+public:
+    static const int class_count = 32;
+
+    explicit WaitEstimator(double initial_service_ms) :
+        mean_service_ms(initial_service_ms),
+        p90_service_ms(initial_service_ms)
+    {
+        for (int i = 0; i < class_count; ++i) queued[i].store(0);
+    }
+
+    static int class_of(bool is_critical, int priority) {
+        return static_cast<int>(PackedKey::make_class(is_critical, priority) >> 59);
+    }
+
+    // Переходы задачи: очередь -> поток -> выполнение -> завершение
+    void enqueued(int item_class) { queued[item_class]++; }
+    void taken(int item_class) { queued[item_class]--; held++; }
+    void returned(int item_class) { held--; queued[item_class]++; }
+    void started() { held--; running++; }
+    void migrated(int item_class) { running--; queued[item_class]++; }  // Прервана и снова в очереди
+
+    void finished(double service_ms) {
+        running--;
+        double mean = mean_service_ms.load();
+        while (!mean_service_ms.compare_exchange_weak(mean, mean + 0.1 * (service_ms - mean))) {
+        }
+        recent.record(static_cast<std::uint64_t>(service_ms));
+        if ((++finished_count & 15) == 0) {
+            p90_service_ms.store(static_cast<double>(recent.percentile(0.9)));
+            if (recent.count() >= 256) recent.reset();  // Гистограмма только последних задач
+        }
+    }
+
+    /*
+    Оценка для гипотетической задачи класса item_class
+    servers - сколько задач выполняется одновременно (0 - выполнять негде)
+     */
+    WaitEstimate estimate(int item_class, int servers) const {
+        int ahead = held.load() + running.load();
+        for (int i = 0; i <= item_class; ++i) ahead += queued[i].load();
+
+        WaitEstimate estimate{ahead, servers, 0.0, 0.0};
+        if (servers <= 0) {
+            estimate.expected_ms = estimate.pessimistic_ms = -1.0;  // Неизвестно: нет исправных процессоров
+        } else if (ahead >= servers) {
+            // Выполняемые в среднем прошли половину; дальше каждые servers
+            // задач очереди впереди - одна длительность
+            double rounds = 0.5 + static_cast<double>(ahead - servers) / servers;
+            estimate.expected_ms = rounds * mean_service_ms.load();
+            estimate.pessimistic_ms = rounds * p90_service_ms.load();
+        }
+        return estimate;
+    }
+
+private:
+    std::atomic<int> queued[class_count];
+    std::atomic<int> held{0};      // Извлечены потоками, еще не начаты
+    std::atomic<int> running{0};
+    std::atomic<double> mean_service_ms;
+    std::atomic<double> p90_service_ms;
+    std::atomic<std::uint64_t> finished_count{0};
+    LatencyHistogram recent;       // Длительности последних задач, мс
+};
+
+#endif